@@ -0,0 +1,99 @@
+#include "BlobStore.hpp"
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+namespace {
+    uint64_t mix(uint64_t value) {
+        value ^= value >> 31;
+        value *= 0xBF58476D1CE4E5B9ull;
+        value ^= value >> 29;
+        return value;
+    }
+
+    struct ViewHash {
+        size_t operator()(std::string_view bytes) const {
+            return static_cast<size_t>(BlobStore::hash(bytes));
+        }
+    };
+}
+
+struct BlobStore::Table {
+    mutable std::mutex mutex;
+    // Keys view the blob's own bytes, so each entry is removed before its
+    // blob is freed
+    std::unordered_map<std::string_view, std::weak_ptr<const std::string>, ViewHash> blobs;
+    Stats stats;
+
+    void release(const std::string* text) {
+        std::lock_guard<std::mutex> lock(mutex);
+        // The entry may already belong to a newer blob with the same bytes,
+        // interned while this one was on its way out
+        auto it = blobs.find(*text);
+        if (it != blobs.end() && it->first.data() == text->data()) {
+            blobs.erase(it);
+        }
+        --stats.blobs;
+        stats.storedBytes -= text->size();
+    }
+};
+
+BlobStore& BlobStore::getInstance() {
+    static BlobStore instance;
+    return instance;
+}
+
+BlobStore::BlobStore() : table(std::make_shared<Table>()) {}
+
+BlobStore::~BlobStore() = default;
+
+BlobStore::Blob BlobStore::intern(std::string_view bytes) {
+    std::lock_guard<std::mutex> lock(table->mutex);
+
+    auto it = table->blobs.find(bytes);
+    if (it != table->blobs.end()) {
+        if (Blob existing = it->second.lock()) {
+            ++table->stats.hits;
+            table->stats.savedBytes += bytes.size();
+            return existing;
+        }
+        table->blobs.erase(it);
+    }
+
+    std::weak_ptr<Table> owner = table;
+    Blob blob(new std::string(bytes), [owner](const std::string* text) {
+        if (auto live = owner.lock()) {
+            live->release(text);
+        }
+        delete text;
+    });
+    table->blobs.emplace(std::string_view(*blob), blob);
+    ++table->stats.blobs;
+    table->stats.storedBytes += blob->size();
+    return blob;
+}
+
+BlobStore::Stats BlobStore::getStats() const {
+    std::lock_guard<std::mutex> lock(table->mutex);
+    return table->stats;
+}
+
+uint64_t BlobStore::hash(std::string_view bytes) {
+    uint64_t hash = 0x9E3779B97F4A7C15ull ^ (bytes.size() * 0xC2B2AE3D27D4EB4Full);
+    const char* data = bytes.data();
+    size_t remaining = bytes.size();
+
+    while (remaining >= 8) {
+        uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        hash = (hash ^ mix(word)) * 0x94D049BB133111EBull;
+        data += 8;
+        remaining -= 8;
+    }
+    if (remaining > 0) {
+        uint64_t word = 0;
+        std::memcpy(&word, data, remaining);
+        hash = (hash ^ mix(word)) * 0x94D049BB133111EBull;
+    }
+    return mix(hash);
+}
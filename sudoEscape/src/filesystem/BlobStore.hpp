@@ -0,0 +1,45 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+// Process-wide store of file content, keyed by a hash of the bytes.
+// Interning bytes that are already stored returns the existing blob, so
+// identical files are kept once whether they sit in the same session or in
+// different ones. Blobs are reference counted through shared_ptr and leave
+// the store together with their last user.
+class BlobStore {
+public:
+    using Blob = std::shared_ptr<const std::string>;
+
+    struct Stats {
+        size_t blobs = 0;
+        // Bytes held by live blobs, each counted once
+        uint64_t storedBytes = 0;
+        // Interns served by an existing blob, and the bytes that saved
+        uint64_t hits = 0;
+        uint64_t savedBytes = 0;
+    };
+
+    static BlobStore& getInstance();
+
+    // Returns the blob holding bytes, creating it if none does
+    Blob intern(std::string_view bytes);
+
+    Stats getStats() const;
+
+    // 64-bit hash used as the store's key, eight bytes at a time
+    static uint64_t hash(std::string_view bytes);
+
+private:
+    BlobStore();
+    ~BlobStore();
+    BlobStore(const BlobStore&) = delete;
+    BlobStore& operator=(const BlobStore&) = delete;
+
+    // Kept behind a shared_ptr so blobs released after the store itself is
+    // destroyed at exit can tell and skip unregistering
+    struct Table;
+    std::shared_ptr<Table> table;
+};
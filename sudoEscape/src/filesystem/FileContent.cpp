@@ -0,0 +1,179 @@
+#include "FileContent.hpp"
+#include "BlobStore.hpp"
+#include "HotContentCache.hpp"
+#include "LzCodec.hpp"
+#include <algorithm>
+
+FileContent::FileContent() : totalSize(0) {}
+
+FileContent::FileContent(std::string_view text) : totalSize(0) {
+    assign(text);
+}
+
+FileContent FileContent::mapped(std::shared_ptr<const void> owner, std::string_view bytes, size_t unpackedSize) {
+    FileContent content;
+    if (unpackedSize > 0) {
+        content.chunks.push_back(Chunk{ std::move(owner), bytes, unpackedSize, unpackedSize != bytes.size(), 0,
+                                        unpackedSize });
+        content.totalSize = unpackedSize;
+    }
+    return content;
+}
+
+size_t FileContent::getStoredSize() const {
+    size_t stored = tail.size();
+    for (const auto& chunk : chunks) {
+        stored += chunk.packed ? chunk.stored.size() : chunk.length;
+    }
+    return stored;
+}
+
+void FileContent::assign(std::string_view text) {
+    clear();
+    totalSize = text.size();
+    while (!text.empty()) {
+        size_t length = std::min(text.size(), CHUNK_SIZE);
+        seal(text.substr(0, length));
+        text.remove_prefix(length);
+    }
+}
+
+void FileContent::append(std::string_view text) {
+    totalSize += text.size();
+
+    if (!tail.empty() || text.size() < CHUNK_SIZE) {
+        size_t fill = std::min(text.size(), CHUNK_SIZE - tail.size());
+        tail.append(text.substr(0, fill));
+        text.remove_prefix(fill);
+        if (tail.size() < CHUNK_SIZE) {
+            return;
+        }
+        seal(tail);
+        tail.clear();
+    }
+
+    // Whatever is left after topping up the tail is sealed chunk by chunk,
+    // except for a short remainder
+    while (text.size() >= CHUNK_SIZE) {
+        seal(text.substr(0, CHUNK_SIZE));
+        text.remove_prefix(CHUNK_SIZE);
+    }
+    tail.assign(text);
+}
+
+void FileContent::clear() {
+    chunks.clear();
+    tail.clear();
+    totalSize = 0;
+}
+
+FileContent FileContent::substr(size_t pos, size_t count) const {
+    FileContent result;
+    if (pos >= totalSize) {
+        return result;
+    }
+    count = std::min(count, totalSize - pos);
+
+    size_t offset = 0;
+    for (const auto& chunk : chunks) {
+        if (count == 0) {
+            return result;
+        }
+        size_t chunkEnd = offset + chunk.length;
+        if (pos < chunkEnd) {
+            Chunk piece = chunk;
+            piece.offset += pos - offset;
+            piece.length = std::min(count, chunkEnd - pos);
+            result.chunks.push_back(piece);
+            result.totalSize += piece.length;
+            pos += piece.length;
+            count -= piece.length;
+        }
+        offset = chunkEnd;
+    }
+
+    // The tail is private to this rope, so the slice gets its own copy
+    if (count > 0) {
+        result.append(std::string_view(tail).substr(pos - offset, count));
+    }
+    return result;
+}
+
+std::string FileContent::toString() const {
+    std::string result;
+    result.reserve(totalSize);
+    forEachChunk([&result](std::string_view piece) {
+        result.append(piece);
+        return true;
+    });
+    return result;
+}
+
+std::string_view FileContent::flatten(std::string& scratch) const {
+    if (chunks.empty()) {
+        return tail;
+    }
+    if (chunks.size() == 1 && tail.empty() && !chunks.front().packed) {
+        std::shared_ptr<const std::string> unused;
+        return view(chunks.front(), unused);
+    }
+    scratch = toString();
+    return scratch;
+}
+
+size_t FileContent::findLastLines(size_t count) const {
+    if (count == 0) {
+        return totalSize;
+    }
+
+    // Walk backwards from the end, unpacking only the chunks reached
+    size_t offset = totalSize;
+    size_t newlines = 0;
+    auto scan = [&](std::string_view piece, size_t& found) {
+        offset -= piece.size();
+        for (size_t i = piece.size(); i-- > 0;) {
+            if (piece[i] == '\n' && offset + i + 1 != totalSize && ++newlines == count) {
+                found = offset + i + 1;
+                return true;
+            }
+        }
+        return false;
+    };
+
+    size_t found = 0;
+    if (!tail.empty() && scan(tail, found)) {
+        return found;
+    }
+    for (auto chunk = chunks.rbegin(); chunk != chunks.rend(); ++chunk) {
+        std::shared_ptr<const std::string> unpacked;
+        if (scan(view(*chunk, unpacked), found)) {
+            return found;
+        }
+    }
+    return 0;
+}
+
+void FileContent::seal(std::string_view text) {
+    // Pack unless it saves too little to be worth unpacking on every cold
+    // read
+    std::string packed;
+    if (text.size() >= MIN_PACK_SIZE) {
+        packed = LzCodec::compress(text);
+    }
+    bool pack = !packed.empty() && packed.size() + packed.size() / 8 < text.size();
+
+    auto blob = BlobStore::getInstance().intern(pack ? std::string_view(packed) : text);
+    chunks.push_back(Chunk{ blob, std::string_view(*blob), text.size(), pack, 0, text.size() });
+}
+
+std::string_view FileContent::view(const Chunk& chunk, std::shared_ptr<const std::string>& hold) {
+    if (!chunk.packed) {
+        return chunk.stored.substr(chunk.offset, chunk.length);
+    }
+    hold = HotContentCache::getInstance().get(chunk.owner, chunk.stored, chunk.unpackedSize);
+    if (!hold) {
+        // Damaged bytes in a mapped image; already logged
+        return std::string_view();
+    }
+    return std::string_view(*hold).substr(chunk.offset, chunk.length);
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Rope holding the contents of one file. Sealed chunks are immutable blobs
+// from the BlobStore, shared between copies and between every file with the
+// same bytes, so copying a node's content or taking a substring never copies
+// the bytes. Appends fill a small private tail that is sealed into a new
+// chunk once full, so growing a file never reallocates it and never touches
+// a blob another file uses.
+//
+// Chunks are stored LzCodec-packed whenever that pays off and unpacked
+// through the HotContentCache when read, so files nobody opens stay small.
+class FileContent {
+public:
+    static constexpr size_t CHUNK_SIZE = 4096;
+    // Smaller chunks are stored as they are
+    static constexpr size_t MIN_PACK_SIZE = 64;
+
+    FileContent();
+    explicit FileContent(std::string_view text);
+
+    // References bytes kept alive by owner (a mapped level image) without
+    // copying them. They are packed if unpackedSize differs from their size.
+    static FileContent mapped(std::shared_ptr<const void> owner, std::string_view bytes, size_t unpackedSize);
+
+    size_t size() const { return totalSize; }
+    // Bytes of storage behind this content, packed chunks at their packed size
+    size_t getStoredSize() const;
+    bool empty() const { return totalSize == 0; }
+
+    // Replaces the content with shared blobs; a file assigned the same bytes
+    // as another one shares its storage
+    void assign(std::string_view text);
+    void append(std::string_view text);
+    void clear();
+
+    // Shares the chunks that overlap [pos, pos + count)
+    FileContent substr(size_t pos, size_t count = std::string::npos) const;
+    std::string toString() const;
+    // Returns the content as one view: directly when it is stored in a single
+    // piece, otherwise copied into scratch
+    std::string_view flatten(std::string& scratch) const;
+
+    // Offset at which the last count lines start. A trailing newline ends the
+    // last line instead of starting an empty one.
+    size_t findLastLines(size_t count) const;
+
+    // visit(std::string_view) is called for each stored piece in order;
+    // returning false stops the walk
+    template <typename Visitor>
+    bool forEachChunk(Visitor&& visit) const {
+        for (const auto& chunk : chunks) {
+            std::shared_ptr<const std::string> unpacked;
+            if (!visit(view(chunk, unpacked))) {
+                return false;
+            }
+        }
+        return tail.empty() || visit(std::string_view(tail));
+    }
+
+    // visit(std::string_view) is called for each line without its newline,
+    // like std::getline. Only lines spanning a chunk boundary are copied.
+    template <typename Visitor>
+    bool forEachLine(Visitor&& visit) const {
+        std::string pending;
+        bool completed = forEachChunk([&](std::string_view piece) {
+            size_t start = 0;
+            size_t end;
+            while ((end = piece.find('\n', start)) != std::string_view::npos) {
+                std::string_view line = piece.substr(start, end - start);
+                if (!pending.empty()) {
+                    pending.append(line);
+                    line = pending;
+                }
+                if (!visit(line)) {
+                    return false;
+                }
+                pending.clear();
+                start = end + 1;
+            }
+            pending.append(piece.substr(start));
+            return true;
+        });
+        return completed && (pending.empty() || visit(std::string_view(pending)));
+    }
+
+private:
+    struct Chunk {
+        // Keeps stored alive: a BlobStore blob or a mapped level image
+        std::shared_ptr<const void> owner;
+        std::string_view stored;
+        size_t unpackedSize;
+        bool packed;
+        // Part of the unpacked bytes this rope uses
+        size_t offset;
+        size_t length;
+    };
+
+    std::vector<Chunk> chunks;
+    std::string tail;
+    size_t totalSize;
+
+    void seal(std::string_view text);
+    // The chunk's bytes, unpacking them into hold if needed; valid while
+    // hold is
+    static std::string_view view(const Chunk& chunk, std::shared_ptr<const std::string>& hold);
+};
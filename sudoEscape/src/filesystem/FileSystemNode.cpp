@@ -2,74 +2,259 @@
 #include <algorithm>
 
 FileSystemNode::FileSystemNode(const std::string& name, NodeType type, const std::string& content)
-    : name(name), type(type), content(content) {}
+    : FileSystemNode(NameTable::getInstance().intern(name), type, content) {}
+
+FileSystemNode::FileSystemNode(NameId nameId, NodeType type, const std::string& content)
+    : nameId(nameId), version(0), type(type), frozen(false), sortedValid(false), lowerHidden(0), pathHandle(0),
+      content(std::string_view(content)), lower(nullptr), parent(nullptr) {
+    static const NameId defaultOwner = NameTable::getInstance().intern(DEFAULT_OWNER);
+    metadata.owner = defaultOwner;
+    switch (type) {
+        case NodeType::DIRECTORY: metadata.mode = 0755; metadata.links = 2; break;
+        case NodeType::SHORTCUT: metadata.mode = 0777; break;
+        case NodeType::FILE: metadata.mode = 0644; break;
+    }
+}
+
+FileSystemNode::FileSystemNode(const FileSystemNode& other)
+    : nameId(other.nameId), version(other.version), type(other.type), frozen(false), sortedValid(false),
+      metadata(other.metadata), lowerHidden(other.lowerHidden),
+      pathHandle(other.pathHandle.load(std::memory_order_relaxed)), content(other.content), lower(other.lower),
+      parent(other.parent) {
+    if (other.frozen && other.isDirectory()) {
+        // Copy-up is O(1): the frozen directory becomes the lower layer
+        lower = const_cast<FileSystemNode*>(&other);
+        lowerHidden = 0;
+        return;
+    }
+    children = other.children;
+    if (other.whiteouts) {
+        whiteouts = std::make_unique<std::unordered_set<NameId>>(*other.whiteouts);
+    }
+    sortedChildren = other.sortedChildren;
+    sortedValid = other.sortedValid;
+}
 
 FileSystemNode::~FileSystemNode() = default;
 
+void FileSystemNode::setName(const std::string& newName) {
+    nameId = NameTable::getInstance().intern(newName);
+}
+
+void FileSystemNode::setTimes(uint32_t modified, uint32_t changed) {
+    metadata.modifiedTime = modified;
+    metadata.changedTime = changed;
+}
+
 void FileSystemNode::setContent(const std::string& newContent) {
-    content = newContent;
+    content.assign(newContent);
+    ++version;
 }
 
 void FileSystemNode::appendContent(const std::string& additionalContent) {
-    content += additionalContent;
+    content.append(additionalContent);
+    ++version;
 }
 
-void FileSystemNode::addChild(std::shared_ptr<FileSystemNode> child) {
+void FileSystemNode::setMappedContent(std::shared_ptr<const void> image, std::string_view view, size_t size) {
+    content = FileContent::mapped(std::move(image), view, size);
+    ++version;
+}
+
+void FileSystemNode::addChild(FileSystemNode* child) {
     if (child) {
-        children[child->getName()] = child;
-        child->setParent(shared_from_this());
+        NameId name = child->getNameId();
+        FileSystemNode*& slot = children[name];
+        FileSystemNode* replaced = slot;
+        if (!replaced && lower) {
+            // Recreating a deleted name swaps its whiteout for the new entry;
+            // otherwise the entry starts hiding the lower one, if any
+            if (whiteouts && whiteouts->erase(name)) {
+                // Still hidden, now by the new entry
+            } else if ((replaced = lower->getChild(name))) {
+                ++lowerHidden;
+            }
+        }
+        slot = child;
+        ++version;
+
+        if (replaced && replaced->isDirectory()) {
+            --metadata.links;
+        }
+        if (child->isDirectory() && metadata.links < UINT16_MAX) {
+            ++metadata.links;
+        }
+
+        if (sortedValid) {
+            if (replaced) {
+                auto it = std::lower_bound(sortedChildren.begin(), sortedChildren.end(), replaced, listOrder);
+                sortedChildren.erase(it);
+            }
+            sortedChildren.insert(std::lower_bound(sortedChildren.begin(), sortedChildren.end(), child, listOrder),
+                                  child);
+        }
+
+        // Shared nodes keep pointing at their snapshot parent, which is at
+        // the same path
+        if (!child->isFrozen()) {
+            // A detached node that already had a path is being moved, which
+            // changes the paths of its whole subtree
+            if (!child->parent && child->pathHandle.load(std::memory_order_relaxed) != 0) {
+                PathTable::getInstance().invalidate();
+            }
+            child->setParent(this);
+        }
     }
 }
 
-void FileSystemNode::removeChild(const std::string& childName) {
+void FileSystemNode::removeChild(std::string_view childName) {
+    NameId id = NameTable::getInstance().find(childName);
+    if (id != NameTable::INVALID_NAME) {
+        removeChild(id);
+    }
+}
+
+void FileSystemNode::removeChild(NameId childName) {
+    FileSystemNode* removed = nullptr;
     auto it = children.find(childName);
     if (it != children.end()) {
-        if (it->second) {
-            it->second->setParent(std::weak_ptr<FileSystemNode>());
-        }
+        removed = it->second;
         children.erase(it);
+        // The lower entry this one was hiding must stay hidden
+        if (lower && lower->getChild(childName)) {
+            if (!whiteouts) {
+                whiteouts = std::make_unique<std::unordered_set<NameId>>();
+            }
+            whiteouts->insert(childName);
+        }
+    } else if (lower && isLowerVisible(childName) && (removed = lower->getChild(childName))) {
+        if (!whiteouts) {
+            whiteouts = std::make_unique<std::unordered_set<NameId>>();
+        }
+        whiteouts->insert(childName);
+        ++lowerHidden;
+    }
+
+    if (removed) {
+        if (removed->isDirectory()) {
+            --metadata.links;
+        }
+        if (!removed->isFrozen()) {
+            removed->setParent(nullptr);
+        }
+        if (sortedValid) {
+            sortedChildren.erase(std::lower_bound(sortedChildren.begin(), sortedChildren.end(), removed, listOrder));
+        }
+        ++version;
     }
 }
 
-std::shared_ptr<FileSystemNode> FileSystemNode::getChild(const std::string& childName) {
+FileSystemNode* FileSystemNode::getChild(std::string_view childName) const {
+    // A name nobody ever interned cannot belong to any child
+    NameId id = NameTable::getInstance().find(childName);
+    return id != NameTable::INVALID_NAME ? getChild(id) : nullptr;
+}
+
+FileSystemNode* FileSystemNode::getChild(NameId childName) const {
     auto it = children.find(childName);
-    return (it != children.end()) ? it->second : nullptr;
+    if (it != children.end()) {
+        return it->second;
+    }
+    if (lower && !(whiteouts && whiteouts->count(childName))) {
+        return lower->getChild(childName);
+    }
+    return nullptr;
+}
+
+bool FileSystemNode::isLowerVisible(NameId name) const {
+    return children.find(name) == children.end() && !(whiteouts && whiteouts->count(name));
 }
 
-std::vector<std::shared_ptr<FileSystemNode>> FileSystemNode::getChildren() const {
-    std::vector<std::shared_ptr<FileSystemNode>> result;
-    for (const auto& pair : children) {
-        result.push_back(pair.second);
+void FileSystemNode::freeze() {
+    frozen = true;
+    // From here on the cached path is trusted whatever the generation
+    pathHandle.store(0, std::memory_order_relaxed);
+    getSortedChildren();
+    for (auto& pair : children) {
+        pair.second->freeze();
     }
+}
+
+std::vector<FileSystemNode*> FileSystemNode::getChildren() const {
+    std::vector<FileSystemNode*> result;
+    result.reserve(getChildCount());
+    forEachChild([&result](FileSystemNode* child) { result.push_back(child); });
     return result;
 }
 
+PathId FileSystemNode::getPathId() const {
+    PathTable& paths = PathTable::getInstance();
+    const uint32_t generation = paths.getGeneration();
+    const uint64_t handle = pathHandle.load(std::memory_order_acquire);
+    if (handle != 0 && (frozen || static_cast<uint32_t>(handle >> 32) == generation)) {
+        return static_cast<PathId>(handle);
+    }
+
+    // Concurrent walkers may both get here; they compute the same id
+    PathId id = parent ? paths.intern(parent->getPathId(), nameId) : PathTable::ROOT_PATH;
+    pathHandle.store((static_cast<uint64_t>(generation) << 32) | id, std::memory_order_release);
+    return id;
+}
+
+const std::vector<FileSystemNode*>& FileSystemNode::getSortedChildren() const {
+    if (!sortedValid) {
+        sortedChildren.clear();
+        sortedChildren.reserve(getChildCount());
+        for (const auto& pair : children) {
+            sortedChildren.push_back(pair.second);
+        }
+        std::sort(sortedChildren.begin(), sortedChildren.end(), listOrder);
+
+        if (lower) {
+            // The lower listing is already sorted; only the own entries need
+            // sorting before the two are merged
+            std::vector<FileSystemNode*> own;
+            own.swap(sortedChildren);
+            sortedChildren.reserve(getChildCount());
+            auto next = own.begin();
+            for (FileSystemNode* child : lower->getSortedChildren()) {
+                if (lowerHidden != 0 && !isLowerVisible(child->getNameId())) {
+                    continue;
+                }
+                while (next != own.end() && listOrder(*next, child)) {
+                    sortedChildren.push_back(*next++);
+                }
+                sortedChildren.push_back(child);
+            }
+            sortedChildren.insert(sortedChildren.end(), next, own.end());
+        }
+        sortedValid = true;
+    }
+    return sortedChildren;
+}
+
 std::vector<FileSystemItem> FileSystemNode::listItems(bool showHidden) const {
+    const auto& sorted = getSortedChildren();
     std::vector<FileSystemItem> items;
+    items.reserve(sorted.size());
 
-    for (const auto& pair : children) {
-        const auto& child = pair.second;
+    for (const FileSystemNode* child : sorted) {
+        std::string_view name = child->getName();
 
         // Skip hidden files unless requested
-        if (!showHidden && child->getName().front() == '.') {
+        if (!showHidden && !name.empty() && name.front() == '.') {
             continue;
         }
 
-        items.emplace_back(
-            child->getName(),
-            child->isDirectory(),
-            child->getSize(),
-            child->getContent()
-        );
+        items.emplace_back(name, child->getType(), child->getSize(), child->getMetadata());
     }
 
-    // Sort items: directories first, then files
-    std::sort(items.begin(), items.end(), [](const FileSystemItem& a, const FileSystemItem& b) {
-        if (a.isDirectory != b.isDirectory) {
-            return a.isDirectory; // Directories first
-        }
-        return a.name < b.name; // Alphabetical within same type
-    });
-
     return items;
 }
+
+bool FileSystemNode::listOrder(const FileSystemNode* a, const FileSystemNode* b) {
+    if (a->isDirectory() != b->isDirectory()) {
+        return a->isDirectory(); // Directories first
+    }
+    return a->getName() < b->getName(); // Alphabetical within same type
+}
@@ -1,61 +1,187 @@
 #pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <memory>
 #include <unordered_map>
+#include <unordered_set>
+#include "FileContent.hpp"
+#include "NameTable.hpp"
+#include "PathTable.hpp"
 
-enum class NodeType {
+enum class NodeType : uint8_t {
     FILE,
     DIRECTORY,
     SHORTCUT
 };
 
+// Inode fields of a node, packed into 16 bytes. Times are seconds on the
+// VFS's simulated clock; the owner is a NameTable id. Sizes are not stored
+// here since FileContent already knows them.
+struct NodeMetadata {
+    uint32_t modifiedTime = 0;
+    uint32_t changedTime = 0;
+    NameId owner = 0;
+    uint16_t mode = 0;
+    // Directories count "." and each subdirectory's "..", as on Unix
+    uint16_t links = 1;
+};
+
+static_assert(sizeof(NodeMetadata) == 16, "NodeMetadata layout changed");
+
+// Listing metadata only; reading a listing never loads file contents. The
+// name points into the NameTable and stays valid for the whole process.
 struct FileSystemItem {
-    std::string name;
+    std::string_view name;
+    NodeType type;
     bool isDirectory;
     size_t size;
-    std::string content;
+    NodeMetadata metadata;
 
-    FileSystemItem(const std::string& n, bool isDir, size_t s = 0, const std::string& c = "")
-        : name(n), isDirectory(isDir), size(s), content(c) {}
+    FileSystemItem(std::string_view n, NodeType t, size_t s = 0, const NodeMetadata& m = NodeMetadata())
+        : name(n), type(t), isDirectory(t == NodeType::DIRECTORY), size(s), metadata(m) {}
 };
 
-class FileSystemNode :  public std::enable_shared_from_this <FileSystemNode> {
+// Nodes are owned by a NodeArena; parent and child links are non-owning.
+// A frozen node belongs to a shared LevelSnapshot and must never be modified;
+// sessions copy it first. The parent of a frozen node is the node at the same
+// path in the snapshot, which may since have been copied by the session.
+//
+// A session's copy of a frozen directory is an overlay: it keeps the frozen
+// original as its lower layer and only stores its own entries and whiteouts
+// for the lower entries it deleted, so copying up a directory or deleting
+// from it never copies the rest of its children.
+class FileSystemNode {
 public:
     FileSystemNode(const std::string& name, NodeType type, const std::string& content = "");
+    FileSystemNode(NameId nameId, NodeType type, const std::string& content = "");
+    // Copy-on-write clone: shares the original's children (as its lower layer
+    // if the original is frozen) and starts unfrozen
+    FileSystemNode(const FileSystemNode& other);
     ~FileSystemNode();
 
+    FileSystemNode& operator=(const FileSystemNode&) = delete;
+
     // Node properties
-    std::string getName() const { return name; }
+    const std::string& getName() const { return NameTable::getInstance().getName(nameId); }
+    NameId getNameId() const { return nameId; }
+    // Only valid while the node is detached, since parents key children by
+    // name
+    void setName(const std::string& newName);
     NodeType getType() const { return type; }
-    std::string getContent() const { return content; }
-    size_t getSize() const { return content.length(); }
+    std::string getContent() const { return content.toString(); }
+    // Read without copying; valid until the node's content changes or its
+    // snapshot is released
+    const FileContent& getFileContent() const { return content; }
+    size_t getSize() const { return content.size(); }
 
     // Content management
     void setContent(const std::string& newContent);
     void appendContent(const std::string& additionalContent);
+    // Points the node at bytes inside a mapped level image, kept alive by
+    // image, instead of owning a copy; pages are only read in when the
+    // content is first accessed. The bytes are packed if size differs.
+    void setMappedContent(std::shared_ptr<const void> image, std::string_view view, size_t size);
 
     // Directory operations
-    void addChild(std::shared_ptr<FileSystemNode> child);
-    void removeChild(const std::string& childName);
-    std::shared_ptr<FileSystemNode> getChild(const std::string& childName);
-    std::vector<std::shared_ptr<FileSystemNode>> getChildren() const;
+    void addChild(FileSystemNode* child);
+    void removeChild(std::string_view childName);
+    void removeChild(NameId childName);
+    FileSystemNode* getChild(std::string_view childName) const;
+    FileSystemNode* getChild(NameId childName) const;
+    std::vector<FileSystemNode*> getChildren() const;
+    // Calls visit(FileSystemNode*) for every child, in no particular order,
+    // without allocating; traversals should prefer this over getChildren()
+    template <typename Visitor>
+    void forEachChild(Visitor&& visit) const {
+        for (const auto& pair : children) {
+            visit(pair.second);
+        }
+        // The lower layer is frozen, so it never has a lower layer of its own
+        if (lower) {
+            for (const auto& pair : lower->children) {
+                if (lowerHidden == 0 || isLowerVisible(pair.first)) {
+                    visit(pair.second);
+                }
+            }
+        }
+    }
+    size_t getChildCount() const {
+        return children.size() + (lower ? lower->getChildCount() - lowerHidden : 0);
+    }
+    // Children in listing order (directories first, then by name). Cached
+    // and kept in step by addChild/removeChild once built.
+    const std::vector<FileSystemNode*>& getSortedChildren() const;
 
     // Navigation
-    std::shared_ptr<FileSystemNode> getParent() const { return parent.lock(); }
-    void setParent(std::weak_ptr<FileSystemNode> parentNode) { parent = parentNode; }
+    FileSystemNode* getParent() const { return parent; }
+    void setParent(FileSystemNode* parentNode) { parent = parentNode; }
+    // Absolute path ("/desktop/Logs", "/" for a root). The node only keeps
+    // the id of its interned path, looked up again after something moved,
+    // so reporting it normally neither walks nor allocates; the string
+    // stays valid for the whole process.
+    const std::string& getPath() const { return PathTable::getInstance().getPath(getPathId()); }
+    PathId getPathId() const;
+    uint16_t getDepth() const { return PathTable::getInstance().getDepth(getPathId()); }
 
     // Utility
     bool isDirectory() const { return type == NodeType::DIRECTORY; }
     bool isFile() const { return type == NodeType::FILE; }
     bool isShortcut() const { return type == NodeType::SHORTCUT; }
 
+    // Bumped whenever a child is added or removed or the content is set or
+    // appended to; copies on write carry it on, so it never goes back for a
+    // path
+    uint32_t getVersion() const { return version; }
+
+    // Inode metadata. New nodes belong to DEFAULT_OWNER with the usual
+    // permissions for their type and time 0 until stamped; link counts are
+    // kept by addChild/removeChild.
+    const NodeMetadata& getMetadata() const { return metadata; }
+    void setMode(uint16_t mode) { metadata.mode = mode; }
+    void setOwner(NameId owner) { metadata.owner = owner; }
+    void setTimes(uint32_t modified, uint32_t changed);
+    // Content or entries changed at time
+    void touch(uint32_t time) { setTimes(time, time); }
+
+    static constexpr const char* DEFAULT_OWNER = "user";
+
+    // Sharing
+    bool isFrozen() const { return frozen; }
+    void freeze();
+
     std::vector<FileSystemItem> listItems(bool showHidden = false) const;
 
 private:
-    std::string name;
+    // Small fields first, so together with the metadata they fill what would
+    // otherwise be padding before the pointer-aligned members
+    NameId nameId;
+    uint32_t version;
     NodeType type;
-    std::string content;
-    std::unordered_map<std::string, std::shared_ptr<FileSystemNode>> children;
-    std::weak_ptr<FileSystemNode> parent;
+    bool frozen : 1;
+    // Built on first listing; frozen nodes build it in freeze() since they
+    // are shared between threads
+    mutable bool sortedValid : 1;
+    NodeMetadata metadata;
+    // Overlays only: how many lower entries are hidden by whiteouts or own
+    // entries
+    uint32_t lowerHidden;
+    // PathTable generation in the high half and path id in the low half, 0
+    // until first asked. Frozen nodes never move, so theirs stays valid;
+    // atomic since walks read paths of shared nodes on several threads.
+    mutable std::atomic<uint64_t> pathHandle;
+    FileContent content;
+    // Own entries; for an overlay these hide lower entries of the same name
+    std::unordered_map<NameId, FileSystemNode*> children;
+    // Overlays only: the frozen directory underneath and the names deleted
+    // from it
+    FileSystemNode* lower;
+    std::unique_ptr<std::unordered_set<NameId>> whiteouts;
+    FileSystemNode* parent;
+    mutable std::vector<FileSystemNode*> sortedChildren;
+
+    bool isLowerVisible(NameId name) const;
+    static bool listOrder(const FileSystemNode* a, const FileSystemNode* b);
 };
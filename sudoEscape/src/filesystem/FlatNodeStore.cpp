@@ -0,0 +1,96 @@
+#include "FlatNodeStore.hpp"
+#include <algorithm>
+
+FlatNodeStore::FlatNodeStore() = default;
+
+FlatNodeStore::~FlatNodeStore() = default;
+
+void FlatNodeStore::build(const FileSystemNode* root) {
+    clear();
+    if (!root) return;
+
+    append(root, INVALID_ID);
+
+    // Breadth-first layout: by the time a node is visited, all of its siblings
+    // have been appended, so its own children land in one contiguous range.
+    // The scratch vector is reused for every node.
+    std::vector<FileSystemNode*> children;
+    for (NodeId id = 0; id < nodes.size(); ++id) {
+        children.clear();
+        nodes[id]->forEachChild([&children](FileSystemNode* child) { children.push_back(child); });
+        std::sort(children.begin(), children.end(), [](const FileSystemNode* a, const FileSystemNode* b) {
+            return a->getName() < b->getName();
+        });
+
+        firstChildren[id] = children.empty() ? INVALID_ID : static_cast<NodeId>(nodes.size());
+        childCounts[id] = static_cast<uint32_t>(children.size());
+
+        for (const auto* child : children) {
+            append(child, id);
+        }
+    }
+}
+
+void FlatNodeStore::clear() {
+    nameIds.clear();
+    types.clear();
+    parents.clear();
+    firstChildren.clear();
+    childCounts.clear();
+    nodes.clear();
+}
+
+NodeId FlatNodeStore::findChild(NodeId parent, NameId name) const {
+    if (parent >= size() || childCounts[parent] == 0) {
+        return INVALID_ID;
+    }
+
+    // Children are sorted by name, so binary search the range
+    const std::string& target = NameTable::getInstance().getName(name);
+    NodeId first = firstChildren[parent];
+    NodeId last = first + childCounts[parent];
+    while (first < last) {
+        NodeId middle = first + (last - first) / 2;
+        if (getName(middle) < target) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+
+    NodeId end = firstChildren[parent] + childCounts[parent];
+    return (first < end && nameIds[first] == name) ? first : INVALID_ID;
+}
+
+NodeId FlatNodeStore::lookup(const std::string& path) const {
+    if (empty()) {
+        return INVALID_ID;
+    }
+
+    NodeId current = ROOT_ID;
+    size_t pos = 0;
+    while (pos < path.size() && current != INVALID_ID) {
+        size_t end = path.find('/', pos);
+        if (end == std::string::npos) {
+            end = path.size();
+        }
+        if (end > pos) {
+            NameId name = NameTable::getInstance().find(std::string_view(path).substr(pos, end - pos));
+            current = (name == NameTable::INVALID_NAME) ? INVALID_ID : findChild(current, name);
+        }
+        pos = end + 1;
+    }
+    return current;
+}
+
+NodeId FlatNodeStore::append(const FileSystemNode* node, NodeId parent) {
+    NodeId id = static_cast<NodeId>(nodes.size());
+
+    nameIds.push_back(node->getNameId());
+    types.push_back(node->getType());
+    parents.push_back(parent);
+    firstChildren.push_back(INVALID_ID);
+    childCounts.push_back(0);
+    nodes.push_back(node);
+    return id;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "FileSystemNode.hpp"
+
+using NodeId = uint32_t;
+
+// Read-optimised copy of a FileSystemNode tree. Nodes are laid out
+// breadth-first and addressed by 32-bit ids, with every column stored in its
+// own contiguous array, so whole-tree scans walk memory linearly instead of
+// chasing child pointers. The children of a node occupy one contiguous id
+// range, sorted by name.
+class FlatNodeStore {
+public:
+    static constexpr NodeId INVALID_ID = 0xFFFFFFFFu;
+    static constexpr NodeId ROOT_ID = 0;
+
+    FlatNodeStore();
+    ~FlatNodeStore();
+
+    void build(const FileSystemNode* root);
+    void clear();
+
+    size_t size() const { return types.size(); }
+    bool empty() const { return types.empty(); }
+
+    // Column accessors
+    const std::string& getName(NodeId id) const { return NameTable::getInstance().getName(nameIds[id]); }
+    NameId getNameId(NodeId id) const { return nameIds[id]; }
+    NodeType getType(NodeId id) const { return types[id]; }
+    NodeId getParent(NodeId id) const { return parents[id]; }
+    NodeId getFirstChild(NodeId id) const { return firstChildren[id]; }
+    uint32_t getChildCount(NodeId id) const { return childCounts[id]; }
+    const FileSystemNode* getNode(NodeId id) const { return nodes[id]; }
+
+    // Child of parent with the given name, or INVALID_ID
+    NodeId findChild(NodeId parent, NameId name) const;
+    // Node at an absolute path, or INVALID_ID
+    NodeId lookup(const std::string& path) const;
+
+    // Absolute path of a node ("/desktop/Logs"), interned in the PathTable
+    const std::string& getPath(NodeId id) const { return nodes[id]->getPath(); }
+
+private:
+    std::vector<NameId> nameIds;
+    std::vector<NodeType> types;
+    std::vector<NodeId> parents;
+    std::vector<NodeId> firstChildren;
+    std::vector<uint32_t> childCounts;
+    std::vector<const FileSystemNode*> nodes;
+
+    NodeId append(const FileSystemNode* node, NodeId parent);
+};
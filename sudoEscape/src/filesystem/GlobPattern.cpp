@@ -0,0 +1,209 @@
+#include "GlobPattern.hpp"
+
+GlobPattern::GlobPattern(std::string_view pattern) {
+    size_t start = 0;
+    while (start <= pattern.size()) {
+        size_t slash = pattern.find('/', start);
+        if (slash == std::string_view::npos) {
+            slash = pattern.size();
+        }
+        // Empty components from doubled, leading or trailing slashes
+        // carry no constraint
+        if (slash > start) {
+            components.push_back(compileComponent(pattern.substr(start, slash - start)));
+        }
+        start = slash + 1;
+    }
+    if (components.empty()) {
+        components.push_back(compileComponent(""));
+    }
+}
+
+bool GlobPattern::hasWildcards(std::string_view text) {
+    return text.find_first_of("*?[") != std::string_view::npos;
+}
+
+bool GlobPattern::matchesName(std::string_view name) const {
+    return matchesComponent(components.back(), name);
+}
+
+bool GlobPattern::matchesPath(std::string_view path) const {
+    // Walk the path once, tracking every component the pattern could be at;
+    // ** can stay where it is or be skipped, and like * it does not enter
+    // hidden directories
+    const size_t count = components.size();
+    std::vector<char> active(count + 1, 0);
+    std::vector<char> next(count + 1, 0);
+
+    auto close = [&](std::vector<char>& states) {
+        for (size_t i = 0; i < count; ++i) {
+            if (states[i] && components[i].recursive) {
+                states[i + 1] = 1;
+            }
+        }
+    };
+
+    active[0] = 1;
+    close(active);
+
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t slash = path.find('/', start);
+        if (slash == std::string_view::npos) {
+            slash = path.size();
+        }
+        std::string_view name = path.substr(start, slash - start);
+        start = slash + 1;
+        if (name.empty()) {
+            continue;
+        }
+
+        std::fill(next.begin(), next.end(), 0);
+        bool any = false;
+        for (size_t i = 0; i < count; ++i) {
+            if (!active[i]) {
+                continue;
+            }
+            if (matchesComponent(components[i], name)) {
+                next[components[i].recursive ? i : i + 1] = 1;
+                any = true;
+            }
+        }
+        if (!any) {
+            return false;
+        }
+        close(next);
+        active.swap(next);
+    }
+
+    return active[count] != 0;
+}
+
+GlobPattern::Component GlobPattern::compileComponent(std::string_view text) {
+    Component component;
+    // ** matches like * within a single name, but may also repeat across
+    // directories
+    if (text == "**") {
+        component.recursive = true;
+        text = "*";
+    }
+    component.matchesHidden = !text.empty() && text.front() == '.';
+    component.pieces.emplace_back();
+
+    for (size_t i = 0; i < text.size(); ++i) {
+        char c = text[i];
+        if (c == '*') {
+            // Runs of stars act as one
+            if (!component.pieces.back().empty() || component.pieces.size() == 1) {
+                component.pieces.emplace_back();
+            }
+            continue;
+        }
+        if (c == '?') {
+            component.pieces.back().push_back(Atom{ Atom::Kind::ANY, 0, 0 });
+            continue;
+        }
+
+        if (c == '[') {
+            // Find the end first: an unterminated '[' is a literal, and a ']'
+            // right after the opening (or after '!') belongs to the set
+            size_t end = i + 1;
+            if (end < text.size() && (text[end] == '!' || text[end] == '^')) {
+                ++end;
+            }
+            if (end < text.size() && text[end] == ']') {
+                ++end;
+            }
+            end = text.find(']', end);
+            if (end != std::string_view::npos) {
+                size_t pos = i + 1;
+                bool negate = text[pos] == '!' || text[pos] == '^';
+                if (negate) {
+                    ++pos;
+                }
+                std::bitset<256> set;
+                for (; pos < end; ++pos) {
+                    unsigned char low = static_cast<unsigned char>(text[pos]);
+                    if (pos + 2 < end && text[pos + 1] == '-') {
+                        unsigned char high = static_cast<unsigned char>(text[pos + 2]);
+                        for (unsigned value = low; value <= high; ++value) {
+                            set.set(value);
+                        }
+                        pos += 2;
+                    } else {
+                        set.set(low);
+                    }
+                }
+                if (negate) {
+                    set.flip();
+                }
+                sets.push_back(set);
+                component.pieces.back().push_back(Atom{ Atom::Kind::SET, 0, sets.size() - 1 });
+                i = end;
+                continue;
+            }
+        }
+
+        component.pieces.back().push_back(Atom{ Atom::Kind::LITERAL, c, 0 });
+    }
+    return component;
+}
+
+bool GlobPattern::matchesComponent(const Component& component, std::string_view name) const {
+    if (!component.matchesHidden && !name.empty() && name.front() == '.') {
+        return false;
+    }
+
+    const auto& pieces = component.pieces;
+    const auto& first = pieces.front();
+    if (pieces.size() == 1) {
+        return name.size() == first.size() && matchesPiece(first, name);
+    }
+
+    // Anchor the first piece at the start and the last at the end, then
+    // place the middle ones leftmost in what remains
+    const auto& last = pieces.back();
+    if (first.size() + last.size() > name.size() || !matchesPiece(first, name.substr(0, first.size())) ||
+        !matchesPiece(last, name.substr(name.size() - last.size()))) {
+        return false;
+    }
+
+    size_t pos = first.size();
+    const size_t limit = name.size() - last.size();
+    for (size_t i = 1; i + 1 < pieces.size(); ++i) {
+        const auto& piece = pieces[i];
+        bool placed = false;
+        for (; pos + piece.size() <= limit; ++pos) {
+            if (matchesPiece(piece, name.substr(pos, piece.size()))) {
+                pos += piece.size();
+                placed = true;
+                break;
+            }
+        }
+        if (!placed) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool GlobPattern::matchesPiece(const std::vector<Atom>& piece, std::string_view text) const {
+    for (size_t i = 0; i < piece.size(); ++i) {
+        const Atom& atom = piece[i];
+        switch (atom.kind) {
+            case Atom::Kind::LITERAL:
+                if (text[i] != atom.literal) {
+                    return false;
+                }
+                break;
+            case Atom::Kind::SET:
+                if (!sets[atom.set].test(static_cast<unsigned char>(text[i]))) {
+                    return false;
+                }
+                break;
+            case Atom::Kind::ANY:
+                break;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <bitset>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Shell-style wildcard pattern, compiled once and then matched cheaply
+// against many names: * matches any run of characters within a name, ? one
+// character, [abc], [a-z] and [!x] one character from a set, and a path
+// component of just ** any number of directories. As in the shell, names
+// starting with '.' only match a component that starts with a literal '.'.
+//
+// Every component is split at its stars into fixed-width pieces; the first
+// and last are anchored and the ones between are placed leftmost-first,
+// which is always correct for globs, so matching never backtracks and takes
+// at most O(name length * pattern length).
+class GlobPattern {
+public:
+    explicit GlobPattern(std::string_view pattern);
+
+    static bool hasWildcards(std::string_view text);
+
+    // True if the pattern has more than one component
+    bool isPathPattern() const { return components.size() > 1; }
+
+    // Matches one name against the last component
+    bool matchesName(std::string_view name) const;
+    // Matches a relative path ("Logs/old/auth.log") component by component
+    bool matchesPath(std::string_view path) const;
+
+private:
+    struct Atom {
+        enum class Kind { LITERAL, ANY, SET };
+        Kind kind;
+        char literal;
+        // Index into sets for SET atoms
+        size_t set;
+    };
+
+    struct Component {
+        // Pieces between stars; a component without stars has one piece
+        std::vector<std::vector<Atom>> pieces;
+        bool recursive = false;
+        bool matchesHidden = false;
+    };
+
+    std::vector<Component> components;
+    std::vector<std::bitset<256>> sets;
+
+    Component compileComponent(std::string_view text);
+    bool matchesComponent(const Component& component, std::string_view name) const;
+    bool matchesPiece(const std::vector<Atom>& piece, std::string_view text) const;
+};
@@ -0,0 +1,87 @@
+#include "HotContentCache.hpp"
+#include "LzCodec.hpp"
+#include "../utils/Logger.hpp"
+
+HotContentCache& HotContentCache::getInstance() {
+    static HotContentCache instance;
+    return instance;
+}
+
+HotContentCache::HotContentCache() : capacity(DEFAULT_CAPACITY) {}
+
+HotContentCache::~HotContentCache() = default;
+
+std::shared_ptr<const std::string> HotContentCache::get(const std::shared_ptr<const void>& owner,
+                                                        std::string_view packed, size_t unpackedSize) {
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        auto it = byKey.find(packed.data());
+        if (it != byKey.end()) {
+            if (!it->second->owner.expired()) {
+                ++stats.hits;
+                entries.splice(entries.begin(), entries, it->second);
+                return it->second->bytes;
+            }
+            stats.bytes -= it->second->bytes->size();
+            entries.erase(it->second);
+            byKey.erase(it);
+        }
+        ++stats.misses;
+    }
+
+    // Unpack outside the lock so readers on other threads are not held up
+    auto bytes = std::make_shared<std::string>();
+    if (!LzCodec::decompress(packed, unpackedSize, *bytes)) {
+        Logger::getInstance().log("Damaged compressed file content (" + std::to_string(packed.size()) + " bytes)");
+        return nullptr;
+    }
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    // Another reader may have unpacked the same bytes in the meantime
+    auto it = byKey.find(packed.data());
+    if (it != byKey.end() && !it->second->owner.expired()) {
+        entries.splice(entries.begin(), entries, it->second);
+        return it->second->bytes;
+    }
+    if (it != byKey.end()) {
+        stats.bytes -= it->second->bytes->size();
+        entries.erase(it->second);
+        byKey.erase(it);
+    }
+
+    entries.push_front(Entry{ packed.data(), owner, bytes });
+    byKey[packed.data()] = entries.begin();
+    stats.bytes += bytes->size();
+    evict();
+    return bytes;
+}
+
+void HotContentCache::setCapacity(size_t bytes) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    capacity = bytes;
+    evict();
+}
+
+void HotContentCache::clear() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    entries.clear();
+    byKey.clear();
+    stats.bytes = 0;
+}
+
+HotContentCache::Stats HotContentCache::getStats() const {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    Stats current = stats;
+    current.entries = entries.size();
+    return current;
+}
+
+void HotContentCache::evict() {
+    // The newest entry stays even if it alone is over budget; its reader
+    // needs it anyway
+    while (stats.bytes > capacity && entries.size() > 1) {
+        stats.bytes -= entries.back().bytes->size();
+        byKey.erase(entries.back().key);
+        entries.pop_back();
+    }
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+// Process-wide LRU of decompressed file contents. Packed content is unpacked
+// on first read and kept here while it stays hot; once the cache outgrows
+// its byte budget the least recently read entries are dropped. Readers hold
+// a shared_ptr, so an entry evicted mid-read stays valid for that reader.
+class HotContentCache {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 16 * 1024 * 1024;
+
+    struct Stats {
+        size_t entries = 0;
+        uint64_t bytes = 0;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+    };
+
+    static HotContentCache& getInstance();
+
+    // Unpacked bytes of packed, which owner keeps alive. Returns nullptr if
+    // the packed bytes are damaged.
+    std::shared_ptr<const std::string> get(const std::shared_ptr<const void>& owner, std::string_view packed,
+                                           size_t unpackedSize);
+
+    void setCapacity(size_t bytes);
+    void clear();
+    Stats getStats() const;
+
+private:
+    HotContentCache();
+    ~HotContentCache();
+    HotContentCache(const HotContentCache&) = delete;
+    HotContentCache& operator=(const HotContentCache&) = delete;
+
+    struct Entry {
+        const char* key;
+        // An address can be reused once its owner is gone, so an entry only
+        // counts while the owner is alive
+        std::weak_ptr<const void> owner;
+        std::shared_ptr<const std::string> bytes;
+    };
+
+    // Most recently used first
+    std::list<Entry> entries;
+    std::unordered_map<const char*, std::list<Entry>::iterator> byKey;
+    size_t capacity;
+    Stats stats;
+    mutable std::mutex cacheMutex;
+
+    void evict();
+};
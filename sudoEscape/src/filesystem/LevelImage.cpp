@@ -0,0 +1,247 @@
+#include "LevelImage.hpp"
+#include "LevelSnapshot.hpp"
+#include "BlobStore.hpp"
+#include "LzCodec.hpp"
+#include "../utils/Logger.hpp"
+#include "../utils/Utils.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+    const char IMAGE_MAGIC[8] = { 'S', 'U', 'D', 'O', 'L', 'V', 'L', '\0' };
+
+    bool inRange(uint64_t offset, uint64_t length, uint64_t limit) {
+        return offset <= limit && length <= limit - offset;
+    }
+}
+
+LevelImage::LevelImage() : header(nullptr), nodes(nullptr), stringPool(nullptr), contentPool(nullptr) {}
+
+LevelImage::~LevelImage() = default;
+
+std::shared_ptr<const LevelImage> LevelImage::open(const std::string& path) {
+    std::shared_ptr<LevelImage> image(new LevelImage());
+    if (!image->file.open(path)) {
+        return nullptr;
+    }
+
+    if (image->file.getSize() < sizeof(LevelImageHeader)) {
+        Logger::getInstance().log("Level image too small: " + path);
+        return nullptr;
+    }
+
+    const char* base = image->file.getData();
+    image->header = reinterpret_cast<const LevelImageHeader*>(base);
+
+    if (!image->validate()) {
+        Logger::getInstance().log("Rejecting malformed level image: " + path);
+        return nullptr;
+    }
+
+    image->nodes = reinterpret_cast<const LevelImageNode*>(base + image->header->nodeTableOffset);
+    image->stringPool = base + image->header->stringPoolOffset;
+    image->contentPool = base + image->header->contentOffset;
+    return image;
+}
+
+bool LevelImage::compile(const LevelSnapshot& snapshot, int64_t sourceStamp, const std::string& path) {
+    return compile(snapshot.getFlatStore(), snapshot.getStartLocation(), snapshot.getClock(), sourceStamp, path);
+}
+
+bool LevelImage::compile(const FlatNodeStore& store, const std::string& startLocation, uint32_t clock,
+                         int64_t sourceStamp, const std::string& path) {
+
+    std::string stringPool;
+    std::unordered_map<NameId, uint32_t> nameOffsets;
+    auto poolString = [&stringPool](std::string_view text) {
+        uint32_t offset = static_cast<uint32_t>(stringPool.size());
+        stringPool.append(text.data(), text.size());
+        return offset;
+    };
+    // Names repeat a lot across a level; store each one once
+    auto poolName = [&](NameId name) {
+        auto known = nameOffsets.find(name);
+        return (known != nameOffsets.end()) ? known->second
+                                            : (nameOffsets[name] = poolString(NameTable::getInstance().getName(name)));
+    };
+
+    std::string contentPool;
+    // Offsets of the contents already pooled, by hash of their stored
+    // bytes, so duplicate files point at one copy
+    std::unordered_multimap<uint64_t, std::pair<uint64_t, NodeId>> contentOffsets;
+    std::vector<LevelImageNode> table(store.size());
+
+    std::string scratch;
+    for (NodeId id = 0; id < store.size(); ++id) {
+        LevelImageNode& record = table[id];
+
+        record.nameOffset = poolName(store.getNameId(id));
+        record.nameLength = static_cast<uint32_t>(store.getName(id).size());
+        record.parent = (id == FlatNodeStore::ROOT_ID) ? NO_PARENT : store.getParent(id);
+        record.firstChild = store.getChildCount(id) ? store.getFirstChild(id) : 0;
+        record.childCount = store.getChildCount(id);
+        record.type = static_cast<uint16_t>(store.getType(id));
+
+        const NodeMetadata& metadata = store.getNode(id)->getMetadata();
+        record.mode = metadata.mode;
+        record.ownerOffset = poolName(metadata.owner);
+        record.ownerLength = static_cast<uint32_t>(NameTable::getInstance().getName(metadata.owner).size());
+        record.modifiedTime = metadata.modifiedTime;
+        record.changedTime = metadata.changedTime;
+
+        std::string_view content = store.getNode(id)->getFileContent().flatten(scratch);
+        record.contentSize = content.size();
+        record.contentOffset = contentPool.size();
+
+        // Same rule as FileContent: keep the packed form when it is clearly
+        // smaller. Packing is deterministic, so equal stored bytes of equal
+        // size still mean equal contents.
+        std::string packed;
+        if (content.size() >= FileContent::MIN_PACK_SIZE) {
+            packed = LzCodec::compress(content);
+            if (packed.size() + packed.size() / 8 < content.size()) {
+                content = packed;
+            }
+        }
+        record.contentLength = content.size();
+
+        if (!content.empty()) {
+            uint64_t hash = BlobStore::hash(content);
+            auto candidates = contentOffsets.equal_range(hash);
+            auto match = std::find_if(candidates.first, candidates.second, [&](const auto& entry) {
+                return table[entry.second.second].contentSize == record.contentSize &&
+                       contentPool.compare(entry.second.first, content.size(), content.data(), content.size()) == 0;
+            });
+            if (match != candidates.second) {
+                record.contentOffset = match->second.first;
+            } else {
+                contentOffsets.emplace(hash, std::make_pair(record.contentOffset, id));
+                contentPool += content;
+            }
+        }
+    }
+
+    LevelImageHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, IMAGE_MAGIC, sizeof(header.magic));
+    header.formatVersion = FORMAT_VERSION;
+    header.nodeCount = static_cast<uint32_t>(table.size());
+    header.sourceStamp = sourceStamp;
+    header.startLocationOffset = poolString(startLocation);
+    header.startLocationLength = static_cast<uint32_t>(startLocation.size());
+    header.clock = clock;
+    header.nodeTableOffset = sizeof(LevelImageHeader);
+    header.stringPoolOffset = header.nodeTableOffset + table.size() * sizeof(LevelImageNode);
+    header.stringPoolSize = stringPool.size();
+    header.contentOffset = header.stringPoolOffset + stringPool.size();
+    header.contentSize = contentPool.size();
+
+    // Write to a temporary file, sync it and rename it over the old image,
+    // so a reader never maps a half-written image and a crash leaves
+    // either the old image or the new one
+    std::string tempPath = path + ".tmp";
+    std::FILE* out = std::fopen(tempPath.c_str(), "wb");
+    if (!out) {
+        Logger::getInstance().log("Cannot create level image: " + tempPath);
+        return false;
+    }
+    bool written = std::fwrite(&header, sizeof(header), 1, out) == 1 &&
+                   std::fwrite(table.data(), sizeof(LevelImageNode), table.size(), out) == table.size() &&
+                   std::fwrite(stringPool.data(), 1, stringPool.size(), out) == stringPool.size() &&
+                   std::fwrite(contentPool.data(), 1, contentPool.size(), out) == contentPool.size() &&
+                   Utils::syncFile(out);
+    written = std::fclose(out) == 0 && written;
+
+    std::error_code error;
+    if (!written) {
+        Logger::getInstance().log("Failed writing level image: " + tempPath);
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    std::filesystem::rename(tempPath, path, error);
+    if (error) {
+        Logger::getInstance().log("Cannot move level image into place: " + path);
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+    return true;
+}
+
+std::string_view LevelImage::getName(uint32_t id) const {
+    return std::string_view(stringPool + nodes[id].nameOffset, nodes[id].nameLength);
+}
+
+std::string_view LevelImage::getOwner(uint32_t id) const {
+    return std::string_view(stringPool + nodes[id].ownerOffset, nodes[id].ownerLength);
+}
+
+std::string_view LevelImage::getContent(uint32_t id) const {
+    return std::string_view(contentPool + nodes[id].contentOffset, static_cast<size_t>(nodes[id].contentLength));
+}
+
+std::string_view LevelImage::getStartLocation() const {
+    return std::string_view(stringPool + header->startLocationOffset, header->startLocationLength);
+}
+
+bool LevelImage::validate() const {
+    const uint64_t fileSize = file.getSize();
+
+    if (std::memcmp(header->magic, IMAGE_MAGIC, sizeof(IMAGE_MAGIC)) != 0 ||
+        header->formatVersion != FORMAT_VERSION || header->nodeCount == 0) {
+        return false;
+    }
+
+    if (header->nodeTableOffset % alignof(LevelImageNode) != 0 ||
+        !inRange(header->nodeTableOffset, uint64_t(header->nodeCount) * sizeof(LevelImageNode), fileSize) ||
+        !inRange(header->stringPoolOffset, header->stringPoolSize, fileSize) ||
+        !inRange(header->contentOffset, header->contentSize, fileSize) ||
+        !inRange(header->startLocationOffset, header->startLocationLength, header->stringPoolSize)) {
+        return false;
+    }
+
+    const auto* table = reinterpret_cast<const LevelImageNode*>(file.getData() + header->nodeTableOffset);
+    const uint32_t count = header->nodeCount;
+
+    if (table[0].parent != NO_PARENT || table[0].type != static_cast<uint16_t>(NodeType::DIRECTORY)) {
+        return false;
+    }
+
+    uint64_t linkedChildren = 0;
+    for (uint32_t id = 0; id < count; ++id) {
+        const LevelImageNode& node = table[id];
+
+        if (node.type > static_cast<uint16_t>(NodeType::SHORTCUT) ||
+            !inRange(node.nameOffset, node.nameLength, header->stringPoolSize) ||
+            !inRange(node.ownerOffset, node.ownerLength, header->stringPoolSize) ||
+            !inRange(node.contentOffset, node.contentLength, header->contentSize) ||
+            node.contentLength > node.contentSize) {
+            return false;
+        }
+        if (id != 0 && node.parent >= id) {
+            return false;
+        }
+
+        // Child ranges must follow their parent and point back at it, which
+        // also rules out cycles
+        if (node.childCount > 0) {
+            if (node.type != static_cast<uint16_t>(NodeType::DIRECTORY) || node.firstChild <= id ||
+                !inRange(node.firstChild, node.childCount, count)) {
+                return false;
+            }
+            for (uint32_t child = node.firstChild; child < node.firstChild + node.childCount; ++child) {
+                if (table[child].parent != id) {
+                    return false;
+                }
+            }
+            linkedChildren += node.childCount;
+        }
+    }
+
+    // Disjoint ranges covering every non-root node: nothing is orphaned
+    return linkedChildren == count - 1;
+}
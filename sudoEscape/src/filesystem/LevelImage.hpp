@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "../utils/MappedFile.hpp"
+
+class LevelSnapshot;
+class FlatNodeStore;
+
+// On-disk layout of a compiled level. All integers are little-endian; the
+// node table is breadth-first with each node's children in one id range,
+// exactly like FlatNodeStore, so it can be used straight from the mapping.
+// Being mapped in place, the structs below are the file format, which only
+// holds on little-endian hosts.
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Level images are mapped in place and little-endian; big-endian hosts are not supported"
+#endif
+
+struct LevelImageHeader {
+    char magic[8];
+    uint32_t formatVersion;
+    uint32_t nodeCount;
+    int64_t sourceStamp;
+    uint64_t nodeTableOffset;
+    uint64_t stringPoolOffset;
+    uint64_t stringPoolSize;
+    uint64_t contentOffset;
+    uint64_t contentSize;
+    uint32_t startLocationOffset;
+    uint32_t startLocationLength;
+    // Simulated time the tree was saved at
+    uint32_t clock;
+    uint32_t reserved;
+};
+
+struct LevelImageNode {
+    uint32_t nameOffset;
+    uint32_t nameLength;
+    uint32_t parent;
+    uint32_t firstChild;
+    uint32_t childCount;
+    uint16_t type;
+    uint16_t mode;
+    // Owner name, in the string pool like node names
+    uint32_t ownerOffset;
+    uint32_t ownerLength;
+    uint32_t modifiedTime;
+    uint32_t changedTime;
+    uint64_t contentOffset;
+    // Stored bytes, LzCodec-packed when shorter than contentSize
+    uint64_t contentLength;
+    uint64_t contentSize;
+};
+
+static_assert(sizeof(LevelImageHeader) == 80, "LevelImageHeader layout changed");
+static_assert(sizeof(LevelImageNode) == 64, "LevelImageNode layout changed");
+
+// A validated, memory-mapped level image
+class LevelImage {
+public:
+    static constexpr uint32_t FORMAT_VERSION = 3;
+    static constexpr uint32_t NO_PARENT = 0xFFFFFFFFu;
+
+    ~LevelImage();
+
+    // Maps and validates path; returns nullptr if it is missing or malformed
+    static std::shared_ptr<const LevelImage> open(const std::string& path);
+    // Writes snapshot as an image. sourceStamp identifies the JSON it came
+    // from so stale images can be detected.
+    static bool compile(const LevelSnapshot& snapshot, int64_t sourceStamp, const std::string& path);
+    // Same for any flattened tree, such as a session's modified file system,
+    // with clock the simulated time it is saved at
+    static bool compile(const FlatNodeStore& store, const std::string& startLocation, uint32_t clock,
+                        int64_t sourceStamp, const std::string& path);
+
+    uint32_t getNodeCount() const { return header->nodeCount; }
+    const LevelImageNode& getNode(uint32_t id) const { return nodes[id]; }
+    std::string_view getName(uint32_t id) const;
+    std::string_view getOwner(uint32_t id) const;
+    // Stored content bytes; packed if shorter than the node's contentSize
+    std::string_view getContent(uint32_t id) const;
+    std::string_view getStartLocation() const;
+    int64_t getSourceStamp() const { return header->sourceStamp; }
+    uint32_t getClock() const { return header->clock; }
+
+private:
+    LevelImage();
+
+    MappedFile file;
+    const LevelImageHeader* header;
+    const LevelImageNode* nodes;
+    const char* stringPool;
+    const char* contentPool;
+
+    bool validate() const;
+};
@@ -0,0 +1,493 @@
+#include "LevelSnapshot.hpp"
+#include "../utils/Logger.hpp"
+#include "../utils/MappedFile.hpp"
+#include <algorithm>
+
+// SAX handler for level files. An item is only complete once its object
+// closes, since keys may come in any order (dumped files even put "items"
+// before "name"), so each node is created then. Children are linked at the
+// end, parents first, so attaching a child never has to re-walk a subtree.
+class LevelSnapshot::StreamingReader {
+public:
+    explicit StreamingReader(LevelSnapshot& snapshot) : snapshot(snapshot) {}
+
+    bool null() { return scalar(nullptr); }
+    bool boolean(bool) { return scalar(nullptr); }
+    bool number_integer(nlohmann::json::number_integer_t value) {
+        return value >= 0 ? number(static_cast<uint64_t>(value)) : scalar(nullptr);
+    }
+    bool number_unsigned(nlohmann::json::number_unsigned_t value) { return number(value); }
+    bool number_float(nlohmann::json::number_float_t, const std::string&) { return scalar(nullptr); }
+    bool binary(nlohmann::json::binary_t&) { return scalar(nullptr); }
+    bool string(std::string& value) { return scalar(&value); }
+
+    bool key(std::string& name) {
+        currentKey = std::move(name);
+        return true;
+    }
+    bool start_object(size_t) {
+        scopes.push_back(open(true));
+        return true;
+    }
+    bool start_array(size_t) {
+        scopes.push_back(open(false));
+        return true;
+    }
+    bool end_object() {
+        close();
+        return true;
+    }
+    bool end_array() {
+        close();
+        return true;
+    }
+    bool parse_error(size_t, const std::string&, const nlohmann::json::exception& e) {
+        Logger::getInstance().log("Error loading JSON: " + std::string(e.what()));
+        return false;
+    }
+
+    void finish() {
+        // Directories were completed children first, so walking them in
+        // reverse reaches every directory before its subdirectories
+        for (auto it = pendingChildren.rbegin(); it != pendingChildren.rend(); ++it) {
+            for (FileSystemNode* child : it->second) {
+                it->first->addChild(child);
+            }
+            std::vector<FileSystemNode*>().swap(it->second);
+        }
+        pendingChildren.clear();
+    }
+
+private:
+    enum class Scope { DOCUMENT, LEVEL_INFO, LOCATIONS, LOCATION, ITEMS, ITEM, SKIP };
+
+    struct Frame {
+        // Locations already exist; items get their node when they close
+        FileSystemNode* node = nullptr;
+        std::string name;
+        std::string type = "file";
+        std::string content;
+        std::string mode;
+        std::string owner;
+        uint32_t modifiedTime = 0;
+        std::vector<FileSystemNode*> children;
+    };
+
+    LevelSnapshot& snapshot;
+    std::vector<Scope> scopes;
+    std::vector<Frame> frames;
+    std::string currentKey;
+    std::vector<std::pair<FileSystemNode*, std::vector<FileSystemNode*>>> pendingChildren;
+
+    Scope open(bool isObject) {
+        if (scopes.empty()) {
+            return isObject ? Scope::DOCUMENT : Scope::SKIP;
+        }
+
+        switch (scopes.back()) {
+            case Scope::DOCUMENT:
+                if (isObject && currentKey == "level_info") {
+                    return Scope::LEVEL_INFO;
+                }
+                if (isObject && currentKey == "locations") {
+                    return Scope::LOCATIONS;
+                }
+                break;
+            case Scope::LOCATIONS: {
+                FileSystemNode* location = snapshot.getLocation(currentKey);
+                if (isObject) {
+                    frames.emplace_back();
+                    frames.back().node = location;
+                    return Scope::LOCATION;
+                }
+                break;
+            }
+            case Scope::LOCATION:
+            case Scope::ITEM:
+                if (!isObject && currentKey == "items") {
+                    return Scope::ITEMS;
+                }
+                break;
+            case Scope::ITEMS:
+                if (isObject) {
+                    frames.emplace_back();
+                    return Scope::ITEM;
+                }
+                break;
+            default:
+                break;
+        }
+        return Scope::SKIP;
+    }
+
+    void close() {
+        Scope scope = scopes.back();
+        scopes.pop_back();
+
+        if (scope == Scope::ITEM) {
+            Frame item = std::move(frames.back());
+            frames.pop_back();
+
+            NodeType nodeType = (item.type == "folder") ? NodeType::DIRECTORY :
+                                (item.type == "shortcut") ? NodeType::SHORTCUT : NodeType::FILE;
+            FileSystemNode* node = snapshot.arena.create(item.name, nodeType, item.content);
+            applyItemMetadata(node, item.mode, item.owner, item.modifiedTime);
+            // Like fromJson, only folders keep nested items
+            if (nodeType == NodeType::DIRECTORY && !item.children.empty()) {
+                pendingChildren.emplace_back(node, std::move(item.children));
+            }
+            frames.back().children.push_back(node);
+        } else if (scope == Scope::LOCATION) {
+            Frame& location = frames.back();
+            if (!location.children.empty()) {
+                pendingChildren.emplace_back(location.node, std::move(location.children));
+            }
+            frames.pop_back();
+        }
+    }
+
+    bool scalar(std::string* value) {
+        if (scopes.empty()) {
+            return true;
+        }
+
+        switch (scopes.back()) {
+            case Scope::LEVEL_INFO:
+                if (value && currentKey == "starting_location") {
+                    snapshot.startLocation = std::move(*value);
+                }
+                break;
+            case Scope::LOCATIONS:
+                snapshot.getLocation(currentKey);
+                break;
+            case Scope::ITEM:
+                if (value) {
+                    Frame& item = frames.back();
+                    if (currentKey == "name") {
+                        item.name = std::move(*value);
+                    } else if (currentKey == "type") {
+                        item.type = std::move(*value);
+                    } else if (currentKey == "content") {
+                        item.content = std::move(*value);
+                    } else if (currentKey == "mode") {
+                        item.mode = std::move(*value);
+                    } else if (currentKey == "owner") {
+                        item.owner = std::move(*value);
+                    }
+                }
+                break;
+            default:
+                break;
+        }
+        return true;
+    }
+
+    bool number(uint64_t value) {
+        if (!scopes.empty() && value <= UINT32_MAX) {
+            if (scopes.back() == Scope::LEVEL_INFO && currentKey == "clock") {
+                snapshot.clock = static_cast<uint32_t>(value);
+            } else if (scopes.back() == Scope::ITEM && currentKey == "mtime") {
+                frames.back().modifiedTime = static_cast<uint32_t>(value);
+            }
+        }
+        return scalar(nullptr);
+    }
+};
+
+LevelSnapshot::LevelSnapshot() : root(nullptr), startLocation("desktop"), clock(DEFAULT_CLOCK) {}
+
+LevelSnapshot::~LevelSnapshot() = default;
+
+std::shared_ptr<const LevelSnapshot> LevelSnapshot::fromJson(const nlohmann::json& levelData) {
+    std::shared_ptr<LevelSnapshot> snapshot(new LevelSnapshot());
+    snapshot->initializeDefaultStructure();
+
+    if (levelData.contains("locations")) {
+        const auto& locations = levelData["locations"];
+
+        for (const auto& [locationName, locationData] : locations.items()) {
+            snapshot->createDirectoryStructure(snapshot->getLocation(locationName), locationData);
+        }
+    }
+
+    if (levelData.contains("level_info") && levelData["level_info"].contains("starting_location")) {
+        snapshot->startLocation = levelData["level_info"]["starting_location"];
+    }
+    if (levelData.contains("level_info") && levelData["level_info"].contains("clock")) {
+        snapshot->clock = levelData["level_info"]["clock"];
+    }
+
+    snapshot->finalize();
+    return snapshot;
+}
+
+std::shared_ptr<const LevelSnapshot> LevelSnapshot::fromJsonFile(const std::string& jsonFile) {
+    // Parsing straight from the mapping avoids holding a copy of the file
+    MappedFile file;
+    if (!file.open(jsonFile)) {
+        Logger::getInstance().log("Cannot open file: " + jsonFile);
+        return nullptr;
+    }
+
+    std::shared_ptr<LevelSnapshot> snapshot(new LevelSnapshot());
+    snapshot->initializeDefaultStructure();
+
+    StreamingReader reader(*snapshot);
+    if (!nlohmann::json::sax_parse(file.getData(), file.getData() + file.getSize(), &reader)) {
+        return nullptr;
+    }
+    reader.finish();
+
+    snapshot->finalize();
+    return snapshot;
+}
+
+std::shared_ptr<const LevelSnapshot> LevelSnapshot::fromImage(std::shared_ptr<const LevelImage> image) {
+    std::shared_ptr<LevelSnapshot> snapshot(new LevelSnapshot());
+    NameTable& names = NameTable::getInstance();
+
+    // Parents always precede their children in the node table. Only content
+    // is served from the mapping; nodes, names and indexes are built here.
+    std::vector<FileSystemNode*> nodes(image->getNodeCount());
+    for (uint32_t id = 0; id < image->getNodeCount(); ++id) {
+        const LevelImageNode& record = image->getNode(id);
+
+        // Content stays in the mapping until a file is read
+        nodes[id] = snapshot->arena.create(names.intern(image->getName(id)), static_cast<NodeType>(record.type));
+        nodes[id]->setMappedContent(image, image->getContent(id), static_cast<size_t>(record.contentSize));
+        nodes[id]->setMode(record.mode);
+        nodes[id]->setOwner(names.intern(image->getOwner(id)));
+        nodes[id]->setTimes(record.modifiedTime, record.changedTime);
+        if (record.parent != LevelImage::NO_PARENT) {
+            nodes[record.parent]->addChild(nodes[id]);
+        }
+    }
+
+    snapshot->root = nodes[0];
+    snapshot->startLocation = std::string(image->getStartLocation());
+    snapshot->clock = image->getClock();
+    snapshot->image = std::move(image);
+    snapshot->finalize();
+    return snapshot;
+}
+
+std::shared_ptr<const LevelSnapshot> LevelSnapshot::fromTree(const nlohmann::json& document) {
+    if (!document.is_object() || !document.contains("root") || !document["root"].is_object()) {
+        Logger::getInstance().log("Tree document has no root");
+        return nullptr;
+    }
+
+    std::shared_ptr<LevelSnapshot> snapshot(new LevelSnapshot());
+    snapshot->root = snapshot->createTreeNode(document["root"]);
+    if (!snapshot->root->isDirectory()) {
+        Logger::getInstance().log("Tree document root is not a directory");
+        return nullptr;
+    }
+    snapshot->startLocation = document.value("start_location", "desktop");
+    snapshot->clock = document.value("clock", DEFAULT_CLOCK);
+    snapshot->finalize();
+    return snapshot;
+}
+
+std::shared_ptr<const LevelSnapshot> LevelSnapshot::createDefault() {
+    std::shared_ptr<LevelSnapshot> snapshot(new LevelSnapshot());
+    snapshot->initializeDefaultStructure();
+    snapshot->finalize();
+    return snapshot;
+}
+
+void LevelSnapshot::initializeDefaultStructure() {
+    root = arena.create("root", NodeType::DIRECTORY);
+
+    // Create desktop directory
+    auto desktop = arena.create("desktop", NodeType::DIRECTORY);
+    root->addChild(desktop);
+
+    // Create basic shortcuts on desktop; a shortcut's content is its target
+    auto myComputer = arena.create("My Computer", NodeType::SHORTCUT, "/");
+    auto fileExplorer = arena.create("File Explorer", NodeType::SHORTCUT, "/desktop");
+
+    desktop->addChild(myComputer);
+    desktop->addChild(fileExplorer);
+}
+
+FileSystemNode* LevelSnapshot::getLocation(const std::string& locationName) {
+    // Merge into an existing location (such as the default desktop) so its
+    // shortcuts survive
+    auto location = root->getChild(locationName);
+    if (!location || !location->isDirectory()) {
+        location = arena.create(locationName, NodeType::DIRECTORY);
+        root->addChild(location);
+    }
+    return location;
+}
+
+void LevelSnapshot::createDirectoryStructure(FileSystemNode* parent, const nlohmann::json& locationData) {
+    if (locationData.contains("items")) {
+        for (const auto& item : locationData["items"]) {
+            std::string name = item.value("name", "");
+            std::string type = item.value("type", "file");
+            std::string content = item.value("content", "");
+
+            NodeType nodeType = (type == "folder") ? NodeType::DIRECTORY : 
+                               (type == "shortcut") ? NodeType::SHORTCUT : NodeType::FILE;
+
+            auto child = arena.create(name, nodeType, content);
+            applyItemMetadata(child, item.value("mode", ""), item.value("owner", ""), item.value("mtime", 0u));
+            parent->addChild(child);
+
+            // If it's a directory and has nested items, create them recursively
+            if (nodeType == NodeType::DIRECTORY && item.contains("items")) {
+                createDirectoryStructure(child, item);
+            }
+        }
+    }
+}
+
+FileSystemNode* LevelSnapshot::createTreeNode(const nlohmann::json& nodeData) {
+    std::string type = nodeData.value("type", "file");
+    NodeType nodeType = (type == "directory") ? NodeType::DIRECTORY :
+                        (type == "shortcut") ? NodeType::SHORTCUT : NodeType::FILE;
+
+    auto node = arena.create(nodeData.value("name", ""), nodeType, nodeData.value("content", ""));
+    const NodeMetadata& metadata = node->getMetadata();
+    node->setMode(nodeData.value("mode", metadata.mode));
+    if (nodeData.contains("owner")) {
+        node->setOwner(NameTable::getInstance().intern(nodeData["owner"].get<std::string>()));
+    }
+    node->setTimes(nodeData.value("mtime", 0u), nodeData.value("ctime", 0u));
+
+    if (nodeType == NodeType::DIRECTORY && nodeData.contains("children")) {
+        for (const auto& child : nodeData["children"]) {
+            node->addChild(createTreeNode(child));
+        }
+    }
+
+    return node;
+}
+
+void LevelSnapshot::applyItemMetadata(FileSystemNode* node, const std::string& mode, const std::string& owner,
+                                      uint32_t modifiedTime) {
+    if (!mode.empty() && mode.size() <= 4 && mode.find_first_not_of("01234567") == std::string::npos) {
+        node->setMode(static_cast<uint16_t>(std::stoul(mode, nullptr, 8)));
+    }
+    if (!owner.empty()) {
+        node->setOwner(NameTable::getInstance().intern(owner));
+    }
+    node->setTimes(modifiedTime, modifiedTime);
+}
+
+void LevelSnapshot::stampTimes(FileSystemNode* node, uint32_t& latest) {
+    const NodeMetadata& metadata = node->getMetadata();
+    if (metadata.modifiedTime == 0) {
+        node->setTimes(clock, metadata.changedTime);
+    }
+    if (metadata.changedTime == 0) {
+        node->setTimes(metadata.modifiedTime, metadata.modifiedTime);
+    }
+    latest = std::max({ latest, metadata.modifiedTime, metadata.changedTime });
+
+    node->forEachChild([this, &latest](FileSystemNode* child) { stampTimes(child, latest); });
+}
+
+void LevelSnapshot::finalize() {
+    // Every node has its times before it is shared, and sessions go on from
+    // the latest of them
+    uint32_t latest = clock;
+    stampTimes(root, latest);
+    clock = latest;
+
+    root->freeze();
+    flatStore.build(root);
+
+    for (NodeId id = FlatNodeStore::ROOT_ID + 1; id < flatStore.size(); ++id) {
+        nameIndex.add(id, flatStore.getName(id));
+    }
+}
+
+const TrigramIndex& LevelSnapshot::getContentIndex() const {
+    std::call_once(contentIndexBuilt, [this]() {
+        std::string scratch;
+        for (NodeId id = FlatNodeStore::ROOT_ID + 1; id < flatStore.size(); ++id) {
+            if (flatStore.getType(id) == NodeType::FILE) {
+                contentIndex.add(id, flatStore.getNode(id)->getFileContent().flatten(scratch));
+            }
+        }
+    });
+    return contentIndex;
+}
+
+LevelSnapshotCache::LevelSnapshotCache() = default;
+
+LevelSnapshotCache::~LevelSnapshotCache() = default;
+
+LevelSnapshotCache& LevelSnapshotCache::getInstance() {
+    static LevelSnapshotCache instance;
+    return instance;
+}
+
+std::shared_ptr<const LevelSnapshot> LevelSnapshotCache::load(const std::string& jsonFile) {
+    // Without the JSON (e.g. only images shipped) any valid image is accepted
+    std::error_code error;
+    auto modified = std::filesystem::last_write_time(jsonFile, error);
+    bool hasSource = !error;
+    int64_t sourceStamp = hasSource ? static_cast<int64_t>(modified.time_since_epoch().count()) : 0;
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto it = entries.find(jsonFile);
+    if (it != entries.end() && (!hasSource || it->second.sourceStamp == sourceStamp)) {
+        return it->second.snapshot;
+    }
+
+    std::string imagePath = getImagePath(jsonFile);
+    std::shared_ptr<const LevelSnapshot> snapshot;
+
+    auto image = LevelImage::open(imagePath);
+    if (image && (!hasSource || image->getSourceStamp() == sourceStamp)) {
+        snapshot = LevelSnapshot::fromImage(image);
+        Logger::getInstance().log("Level image mapped: " + imagePath);
+    } else {
+        if (!hasSource) {
+            Logger::getInstance().log("Cannot open file: " + jsonFile);
+            return nullptr;
+        }
+
+        snapshot = parseJson(jsonFile);
+        if (!snapshot) {
+            return nullptr;
+        }
+
+        // Compile once so the next start can map the image instead. Serve
+        // this run from the image too, so file contents are dropped with the
+        // parsed tree and only read back when a file is opened.
+        if (LevelImage::compile(*snapshot, sourceStamp, imagePath)) {
+            Logger::getInstance().log("Level image compiled: " + imagePath);
+            if (auto compiled = LevelImage::open(imagePath)) {
+                snapshot = LevelSnapshot::fromImage(compiled);
+            }
+        }
+    }
+
+    entries[jsonFile] = Entry{ snapshot, sourceStamp };
+    Logger::getInstance().log("Level snapshot built: " + jsonFile + " (" +
+                              std::to_string(snapshot->getNodeCount()) + " nodes)");
+    return snapshot;
+}
+
+void LevelSnapshotCache::clear() {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    entries.clear();
+}
+
+std::string LevelSnapshotCache::getImagePath(const std::string& jsonFile) {
+    return std::filesystem::path(jsonFile).replace_extension(".lvl").string();
+}
+
+std::shared_ptr<const LevelSnapshot> LevelSnapshotCache::parseJson(const std::string& jsonFile) {
+    try {
+        return LevelSnapshot::fromJsonFile(jsonFile);
+    } catch (const std::exception& e) {
+        Logger::getInstance().log("Error loading JSON: " + std::string(e.what()));
+        return nullptr;
+    }
+}
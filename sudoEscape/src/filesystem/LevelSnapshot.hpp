@@ -0,0 +1,114 @@
+#pragma once
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+#include "FileSystemNode.hpp"
+#include "NodeArena.hpp"
+#include "FlatNodeStore.hpp"
+#include "TrigramIndex.hpp"
+#include "LevelImage.hpp"
+
+// Immutable file system tree built once per level and shared by every session
+// playing it. All nodes are frozen; sessions copy the nodes they change.
+class LevelSnapshot {
+public:
+    ~LevelSnapshot();
+
+    LevelSnapshot(const LevelSnapshot&) = delete;
+    LevelSnapshot& operator=(const LevelSnapshot&) = delete;
+
+    static std::shared_ptr<const LevelSnapshot> fromJson(const nlohmann::json& levelData);
+    // Same as fromJson on the parsed file, but builds nodes while the file
+    // is read instead of going through a document, so loading needs little
+    // more memory than the finished tree. Returns nullptr if the file cannot
+    // be read or is not valid JSON.
+    static std::shared_ptr<const LevelSnapshot> fromJsonFile(const std::string& jsonFile);
+    // Builds the tree straight from a compiled image. Nothing is parsed and
+    // file contents stay in the mapping, but every node is still created,
+    // and the flat store and name index built, so this takes time linear
+    // in the number of nodes.
+    static std::shared_ptr<const LevelSnapshot> fromImage(std::shared_ptr<const LevelImage> image);
+    // Rebuilds a tree written by VirtualFileSystem::encodeTree; returns
+    // nullptr if the document is malformed
+    static std::shared_ptr<const LevelSnapshot> fromTree(const nlohmann::json& document);
+    // Desktop with the standard shortcuts, used when no level is loaded
+    static std::shared_ptr<const LevelSnapshot> createDefault();
+
+    FileSystemNode* getRoot() const { return root; }
+    const std::string& getStartLocation() const { return startLocation; }
+    // Simulated time sessions on this level start at: the level's
+    // level_info.clock (DEFAULT_CLOCK if missing) or the latest time on any
+    // node, whichever is later. Nodes without a time get the level's clock.
+    uint32_t getClock() const { return clock; }
+    const FlatNodeStore& getFlatStore() const { return flatStore; }
+    // Trigram index over node names, keyed by flat store id
+    const TrigramIndex& getNameIndex() const { return nameIndex; }
+    // Trigram index over file contents, keyed by flat store id. Built on
+    // first use so loading a level does not read every file
+    const TrigramIndex& getContentIndex() const;
+    size_t getNodeCount() const { return arena.getNodeCount(); }
+
+    // 2025-01-15 10:30 UTC, in seconds since the Unix epoch
+    static constexpr uint32_t DEFAULT_CLOCK = 1736937000;
+
+private:
+    class StreamingReader;
+
+    LevelSnapshot();
+
+    NodeArena arena;
+    FileSystemNode* root;
+    std::string startLocation;
+    uint32_t clock;
+    std::shared_ptr<const LevelImage> image;
+    FlatNodeStore flatStore;
+    TrigramIndex nameIndex;
+    mutable TrigramIndex contentIndex;
+    mutable std::once_flag contentIndexBuilt;
+
+    void initializeDefaultStructure();
+    void createDirectoryStructure(FileSystemNode* parent, const nlohmann::json& locationData);
+    FileSystemNode* getLocation(const std::string& locationName);
+    // Applies the optional "mode" (octal string), "owner" and "mtime" of a
+    // level item; malformed values are ignored
+    static void applyItemMetadata(FileSystemNode* node, const std::string& mode, const std::string& owner,
+                                  uint32_t modifiedTime);
+    void stampTimes(FileSystemNode* node, uint32_t& latest);
+    FileSystemNode* createTreeNode(const nlohmann::json& nodeData);
+    void finalize();
+};
+
+// Process-wide cache of parsed levels, keyed by file path
+class LevelSnapshotCache {
+public:
+    static LevelSnapshotCache& getInstance();
+
+    // Returns the shared snapshot for jsonFile, loading it on first use or
+    // when the file changed on disk. A compiled image next to the JSON
+    // (level1.json -> level1.lvl) is mapped instead of parsing whenever it is
+    // up to date; otherwise the JSON is parsed and the image (re)compiled.
+    // Returns nullptr if the level cannot be loaded.
+    std::shared_ptr<const LevelSnapshot> load(const std::string& jsonFile);
+    void clear();
+
+    static std::string getImagePath(const std::string& jsonFile);
+
+private:
+    LevelSnapshotCache();
+    ~LevelSnapshotCache();
+    LevelSnapshotCache(const LevelSnapshotCache&) = delete;
+    LevelSnapshotCache& operator=(const LevelSnapshotCache&) = delete;
+
+    struct Entry {
+        std::shared_ptr<const LevelSnapshot> snapshot;
+        int64_t sourceStamp;
+    };
+
+    std::unordered_map<std::string, Entry> entries;
+    std::mutex cacheMutex;
+
+    std::shared_ptr<const LevelSnapshot> parseJson(const std::string& jsonFile);
+};
@@ -0,0 +1,141 @@
+#include "LzCodec.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace {
+    constexpr unsigned HASH_BITS = 12;
+
+    uint32_t read32(const char* data) {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+
+    uint32_t hashOf(uint32_t sequence) {
+        return (sequence * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    // Lengths past the nibble continue in bytes of up to 255
+    void putLength(std::string& out, size_t length) {
+        while (length >= 255) {
+            out.push_back(static_cast<char>(255));
+            length -= 255;
+        }
+        out.push_back(static_cast<char>(length));
+    }
+
+    bool getLength(std::string_view packed, size_t& pos, size_t& length) {
+        while (true) {
+            if (pos >= packed.size()) {
+                return false;
+            }
+            uint8_t byte = static_cast<uint8_t>(packed[pos++]);
+            length += byte;
+            if (byte != 255) {
+                return true;
+            }
+        }
+    }
+
+    void putSequence(std::string& out, std::string_view literals, size_t offset, size_t matchLength) {
+        size_t extraMatch = matchLength ? matchLength - LzCodec::MIN_MATCH : 0;
+        uint8_t token = static_cast<uint8_t>((std::min<size_t>(literals.size(), 15) << 4) |
+                                             std::min<size_t>(extraMatch, 15));
+        out.push_back(static_cast<char>(token));
+        if (literals.size() >= 15) {
+            putLength(out, literals.size() - 15);
+        }
+        out.append(literals);
+        if (matchLength == 0) {
+            return;
+        }
+        out.push_back(static_cast<char>(offset & 0xFF));
+        out.push_back(static_cast<char>(offset >> 8));
+        if (extraMatch >= 15) {
+            putLength(out, extraMatch - 15);
+        }
+    }
+}
+
+std::string LzCodec::compress(std::string_view input) {
+    std::string out;
+    out.reserve(input.size() / 2 + 16);
+
+    // Last position + 1 at which each hashed four-byte sequence was seen
+    std::vector<uint32_t> table(size_t(1) << HASH_BITS, 0);
+    const char* data = input.data();
+    size_t anchor = 0;
+    size_t pos = 0;
+
+    while (pos + MIN_MATCH <= input.size()) {
+        uint32_t sequence = read32(data + pos);
+        uint32_t& slot = table[hashOf(sequence)];
+        size_t candidate = slot;
+        slot = static_cast<uint32_t>(pos + 1);
+
+        if (candidate == 0 || pos - (candidate - 1) > MAX_OFFSET || read32(data + candidate - 1) != sequence) {
+            ++pos;
+            continue;
+        }
+        size_t match = candidate - 1;
+        size_t length = MIN_MATCH;
+        while (pos + length < input.size() && data[match + length] == data[pos + length]) {
+            ++length;
+        }
+
+        putSequence(out, input.substr(anchor, pos - anchor), pos - match, length);
+        pos += length;
+        anchor = pos;
+    }
+
+    putSequence(out, input.substr(anchor), 0, 0);
+    return out;
+}
+
+bool LzCodec::decompress(std::string_view packed, size_t originalSize, std::string& output) {
+    output.clear();
+    output.reserve(originalSize);
+    size_t pos = 0;
+
+    while (pos < packed.size()) {
+        uint8_t token = static_cast<uint8_t>(packed[pos++]);
+
+        size_t literals = token >> 4;
+        if (literals == 15 && !getLength(packed, pos, literals)) {
+            return false;
+        }
+        if (literals > packed.size() - pos || literals > originalSize - output.size()) {
+            return false;
+        }
+        output.append(packed.substr(pos, literals));
+        pos += literals;
+
+        if (pos == packed.size()) {
+            break;
+        }
+
+        if (packed.size() - pos < 2) {
+            return false;
+        }
+        size_t offset = static_cast<uint8_t>(packed[pos]) | (size_t(static_cast<uint8_t>(packed[pos + 1])) << 8);
+        pos += 2;
+        size_t length = token & 0x0F;
+        if (length == 15 && !getLength(packed, pos, length)) {
+            return false;
+        }
+        length += MIN_MATCH;
+        if (offset == 0 || offset > output.size() || length > originalSize - output.size()) {
+            return false;
+        }
+
+        // Matches may overlap their own output (a run), so copy forwards
+        size_t from = output.size() - offset;
+        for (size_t i = 0; i < length; ++i) {
+            output.push_back(output[from + i]);
+        }
+    }
+
+    return output.size() == originalSize;
+}
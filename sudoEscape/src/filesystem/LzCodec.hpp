@@ -0,0 +1,21 @@
+#pragma once
+#include <string>
+#include <string_view>
+
+// Small LZ77 codec for file contents, in the spirit of LZ4: a packed block
+// is a run of sequences, each a token byte (literal count in the high
+// nibble, match length - MIN_MATCH in the low one, 15 meaning "more length
+// bytes follow"), the literals, then a two-byte back-reference offset. The
+// last sequence has literals only. Fast rather than tight, which suits log
+// text that is read far more often than it is written.
+class LzCodec {
+public:
+    static constexpr size_t MIN_MATCH = 4;
+    static constexpr size_t MAX_OFFSET = 65535;
+
+    static std::string compress(std::string_view input);
+    // Unpacks a block produced by compress(). Packed bytes may come from a
+    // damaged file, so every length and offset is checked; returns false
+    // unless exactly originalSize bytes come out.
+    static bool decompress(std::string_view packed, size_t originalSize, std::string& output);
+};
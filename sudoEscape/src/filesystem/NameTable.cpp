@@ -0,0 +1,54 @@
+#include "NameTable.hpp"
+#include <stdexcept>
+
+NameTable::NameTable() : count(0) {}
+
+NameTable::~NameTable() = default;
+
+NameTable& NameTable::getInstance() {
+    static NameTable instance;
+    return instance;
+}
+
+NameId NameTable::intern(std::string_view name) {
+    {
+        std::shared_lock<std::shared_mutex> lock(tableMutex);
+        auto it = ids.find(name);
+        if (it != ids.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(tableMutex);
+    auto it = ids.find(name);
+    if (it != ids.end()) {
+        return it->second;
+    }
+
+    uint32_t chunk = count >> CHUNK_BITS;
+    if (chunk >= MAX_CHUNKS) {
+        throw std::length_error("NameTable is full");
+    }
+    if (!chunks[chunk]) {
+        chunks[chunk].reset(new std::string[CHUNK_SIZE]);
+    }
+
+    NameId id = count++;
+    std::string& stored = chunks[chunk][id & CHUNK_MASK];
+    stored.assign(name.data(), name.size());
+
+    // Key by a view of the stored copy so each name lives in memory once
+    ids.emplace(std::string_view(stored), id);
+    return id;
+}
+
+NameId NameTable::find(std::string_view name) const {
+    std::shared_lock<std::shared_mutex> lock(tableMutex);
+    auto it = ids.find(name);
+    return it != ids.end() ? it->second : INVALID_NAME;
+}
+
+size_t NameTable::size() const {
+    std::shared_lock<std::shared_mutex> lock(tableMutex);
+    return count;
+}
@@ -0,0 +1,48 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+using NameId = uint32_t;
+
+// Process-wide table of node names. Every distinct name is stored once and
+// handed out as a 32-bit id, so nodes from any number of sessions share the
+// same copy and name comparisons are integer compares.
+class NameTable {
+public:
+    static constexpr NameId INVALID_NAME = 0xFFFFFFFFu;
+
+    static NameTable& getInstance();
+
+    // Returns the id for name, adding it on first use
+    NameId intern(std::string_view name);
+    // Returns the id for name, or INVALID_NAME if it was never interned
+    NameId find(std::string_view name) const;
+
+    // Lock-free: entries never move once published
+    const std::string& getName(NameId id) const {
+        return chunks[id >> CHUNK_BITS][id & CHUNK_MASK];
+    }
+
+    size_t size() const;
+
+private:
+    NameTable();
+    ~NameTable();
+    NameTable(const NameTable&) = delete;
+    NameTable& operator=(const NameTable&) = delete;
+
+    static constexpr uint32_t CHUNK_BITS = 12;
+    static constexpr uint32_t CHUNK_SIZE = 1u << CHUNK_BITS;
+    static constexpr uint32_t CHUNK_MASK = CHUNK_SIZE - 1;
+    static constexpr uint32_t MAX_CHUNKS = 4096;
+
+    std::unique_ptr<std::string[]> chunks[MAX_CHUNKS];
+    std::unordered_map<std::string_view, NameId> ids;
+    uint32_t count;
+    mutable std::shared_mutex tableMutex;
+};
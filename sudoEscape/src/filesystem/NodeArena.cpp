@@ -0,0 +1,49 @@
+#include "NodeArena.hpp"
+#include <algorithm>
+
+NodeArena::NodeArena() : nodeCount(0) {}
+
+NodeArena::~NodeArena() {
+    release();
+}
+
+void NodeArena::release() {
+    for (auto& block : blocks) {
+        for (size_t i = 0; i < block.used; ++i) {
+            slotAt(block, i)->~FileSystemNode();
+        }
+    }
+    blocks.clear();
+    nodeCount = 0;
+}
+
+size_t NodeArena::getReservedBytes() const {
+    size_t bytes = 0;
+    for (const auto& block : blocks) {
+        bytes += block.capacity * sizeof(FileSystemNode);
+    }
+    return bytes;
+}
+
+void* NodeArena::allocateSlot() {
+    if (blocks.empty() || blocks.back().used == blocks.back().capacity) {
+        // Grow geometrically so small levels stay small and big ones need few blocks
+        size_t capacity = blocks.empty() ? FIRST_BLOCK_NODES
+                                         : std::min(blocks.back().capacity * 2, MAX_BLOCK_NODES);
+
+        Block block;
+        // operator new[] on unsigned char is aligned for any fundamental type,
+        // which covers FileSystemNode
+        block.storage.reset(new unsigned char[capacity * sizeof(FileSystemNode)]);
+        block.capacity = capacity;
+        block.used = 0;
+        blocks.push_back(std::move(block));
+    }
+
+    Block& block = blocks.back();
+    return slotAt(block, block.used);
+}
+
+FileSystemNode* NodeArena::slotAt(const Block& block, size_t index) const {
+    return reinterpret_cast<FileSystemNode*>(block.storage.get() + index * sizeof(FileSystemNode));
+}
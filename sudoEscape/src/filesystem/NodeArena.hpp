@@ -0,0 +1,52 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+#include "FileSystemNode.hpp"
+
+// Owns every FileSystemNode of one VirtualFileSystem. Nodes are placed into
+// large blocks instead of being allocated one by one, and the whole tree is
+// torn down with a single release() call.
+class NodeArena {
+public:
+    NodeArena();
+    ~NodeArena();
+
+    NodeArena(const NodeArena&) = delete;
+    NodeArena& operator=(const NodeArena&) = delete;
+
+    template <typename... Args>
+    FileSystemNode* create(Args&&... args) {
+        void* slot = allocateSlot();
+        FileSystemNode* node = new (slot) FileSystemNode(std::forward<Args>(args)...);
+        // Only count the slot once construction succeeded, so release() never
+        // runs a destructor on raw memory
+        ++blocks.back().used;
+        ++nodeCount;
+        return node;
+    }
+
+    // Destroys every node and returns all blocks to the heap
+    void release();
+
+    size_t getNodeCount() const { return nodeCount; }
+    size_t getReservedBytes() const;
+
+private:
+    struct Block {
+        std::unique_ptr<unsigned char[]> storage;
+        size_t capacity;
+        size_t used;
+    };
+
+    static constexpr size_t FIRST_BLOCK_NODES = 64;
+    static constexpr size_t MAX_BLOCK_NODES = 16384;
+
+    std::vector<Block> blocks;
+    size_t nodeCount;
+
+    void* allocateSlot();
+    FileSystemNode* slotAt(const Block& block, size_t index) const;
+};
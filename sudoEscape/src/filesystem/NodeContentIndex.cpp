@@ -0,0 +1,139 @@
+#include "NodeContentIndex.hpp"
+#include "LevelSnapshot.hpp"
+#include <algorithm>
+
+NodeContentIndex::NodeContentIndex() : baseStore(nullptr), baseSnapshot(nullptr) {}
+
+NodeContentIndex::~NodeContentIndex() = default;
+
+void NodeContentIndex::attach(const LevelSnapshot& snapshot) {
+    baseStore = &snapshot.getFlatStore();
+    baseSnapshot = &snapshot;
+    maskedBaseNodes.clear();
+    addedEntries.clear();
+    addedByPath.clear();
+    addedIndex.clear();
+}
+
+void NodeContentIndex::addFile(const std::string& path, std::string_view content) {
+    TrigramIndex::DocId doc = static_cast<TrigramIndex::DocId>(addedEntries.size());
+    addedEntries.push_back(Entry{ path, true });
+    addedByPath[path] = doc;
+    addedIndex.add(doc, content);
+}
+
+void NodeContentIndex::updateFile(const std::string& path, const FileContent& oldContent, std::string_view newContent) {
+    std::string scratch;
+    std::string_view old = oldContent.flatten(scratch);
+    TrigramIndex::DocId doc = takeOver(path, old);
+    addedIndex.remove(doc, old);
+    addedIndex.add(doc, newContent);
+}
+
+void NodeContentIndex::appendFile(const std::string& path, const FileContent& oldContent, std::string_view appended) {
+    auto existing = addedByPath.find(path);
+    if (existing == addedByPath.end() || !addedEntries[existing->second].live) {
+        std::string scratch;
+        takeOver(path, oldContent.flatten(scratch));
+    }
+    TrigramIndex::DocId doc = addedByPath[path];
+
+    // Only trigrams that touch the appended text are new; include the last
+    // two old bytes so trigrams spanning the boundary are indexed too
+    size_t overlap = std::min<size_t>(oldContent.size(), TrigramIndex::MIN_QUERY_LENGTH - 1);
+    std::string boundary = oldContent.substr(oldContent.size() - overlap).toString();
+    addedIndex.add(doc, boundary.append(appended));
+}
+
+void NodeContentIndex::removeSubtree(const FileSystemNode* node, const std::string& path) {
+    std::string buffer = path;
+    removeRecursive(node, buffer, baseStore ? baseStore->lookup(path) : FlatNodeStore::INVALID_ID);
+}
+
+std::vector<std::string> NodeContentIndex::candidates(const std::string& pattern) const {
+    std::vector<std::string> results;
+
+    auto isLiveBaseFile = [this](NodeId id) {
+        return baseStore->getType(id) == NodeType::FILE &&
+               !(id < maskedBaseNodes.size() && maskedBaseNodes[id]);
+    };
+
+    if (pattern.size() >= TrigramIndex::MIN_QUERY_LENGTH) {
+        if (baseStore) {
+            for (NodeId id : baseSnapshot->getContentIndex().candidates(pattern)) {
+                if (isLiveBaseFile(id)) {
+                    results.push_back(baseStore->getPath(id));
+                }
+            }
+        }
+        for (TrigramIndex::DocId doc : addedIndex.candidates(pattern)) {
+            if (addedEntries[doc].live) {
+                results.push_back(addedEntries[doc].path);
+            }
+        }
+    } else {
+        if (baseStore) {
+            for (NodeId id = FlatNodeStore::ROOT_ID + 1; id < baseStore->size(); ++id) {
+                if (isLiveBaseFile(id)) {
+                    results.push_back(baseStore->getPath(id));
+                }
+            }
+        }
+        for (const auto& entry : addedEntries) {
+            if (entry.live) {
+                results.push_back(entry.path);
+            }
+        }
+    }
+
+    std::sort(results.begin(), results.end());
+    return results;
+}
+
+void NodeContentIndex::maskBaseNode(NodeId id) {
+    if (maskedBaseNodes.size() < baseStore->size()) {
+        maskedBaseNodes.resize(baseStore->size(), false);
+    }
+    maskedBaseNodes[id] = true;
+}
+
+TrigramIndex::DocId NodeContentIndex::takeOver(const std::string& path, std::string_view oldContent) {
+    auto existing = addedByPath.find(path);
+    if (existing != addedByPath.end() && addedEntries[existing->second].live) {
+        return existing->second;
+    }
+
+    // First change to a snapshot file: hide the shared entry and track the
+    // file privately from here on
+    NodeId baseId = (baseStore ? baseStore->lookup(path) : FlatNodeStore::INVALID_ID);
+    if (baseId != FlatNodeStore::INVALID_ID) {
+        maskBaseNode(baseId);
+    }
+    addFile(path, oldContent);
+    return addedByPath[path];
+}
+
+void NodeContentIndex::removeRecursive(const FileSystemNode* node, std::string& path, NodeId baseId) {
+    auto added = addedByPath.find(path);
+    if (added != addedByPath.end() && addedEntries[added->second].live) {
+        addedEntries[added->second].live = false;
+        std::string scratch;
+        addedIndex.remove(added->second, node->getFileContent().flatten(scratch));
+        addedByPath.erase(added);
+    } else if (baseId != FlatNodeStore::INVALID_ID) {
+        maskBaseNode(baseId);
+    }
+
+    node->forEachChild([&](const FileSystemNode* child) {
+        size_t length = path.size();
+        if (path.empty() || path.back() != '/') {
+            path += '/';
+        }
+        path += child->getName();
+
+        NodeId childBaseId = (baseId != FlatNodeStore::INVALID_ID) ? baseStore->findChild(baseId, child->getNameId())
+                                                                  : FlatNodeStore::INVALID_ID;
+        removeRecursive(child, path, childBaseId);
+        path.resize(length);
+    });
+}
@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "FileSystemNode.hpp"
+#include "FlatNodeStore.hpp"
+#include "TrigramIndex.hpp"
+
+class LevelSnapshot;
+
+// Full-text trigram index over file contents for one session. Like
+// NodeNameIndex, the snapshot's prebuilt index covers unmodified files and
+// this class tracks the files the session created, rewrote or appended to.
+class NodeContentIndex {
+public:
+    NodeContentIndex();
+    ~NodeContentIndex();
+
+    // Starts over on top of snapshot, discarding every session change
+    void attach(const LevelSnapshot& snapshot);
+
+    void addFile(const std::string& path, std::string_view content);
+    // oldContent is what the file held before the write
+    void updateFile(const std::string& path, const FileContent& oldContent, std::string_view newContent);
+    void appendFile(const std::string& path, const FileContent& oldContent, std::string_view appended);
+    void removeSubtree(const FileSystemNode* node, const std::string& path);
+
+    // Absolute paths of files that may contain pattern (every file when the
+    // pattern is too short to use trigrams). Callers verify the matches.
+    std::vector<std::string> candidates(const std::string& pattern) const;
+
+private:
+    struct Entry {
+        std::string path;
+        bool live;
+    };
+
+    const FlatNodeStore* baseStore;
+    // The snapshot builds its content index on first query, not on attach
+    const LevelSnapshot* baseSnapshot;
+    std::vector<bool> maskedBaseNodes;
+
+    std::vector<Entry> addedEntries;
+    std::unordered_map<std::string, TrigramIndex::DocId> addedByPath;
+    TrigramIndex addedIndex;
+
+    void maskBaseNode(NodeId id);
+    TrigramIndex::DocId takeOver(const std::string& path, std::string_view oldContent);
+    void removeRecursive(const FileSystemNode* node, std::string& path, NodeId baseId);
+};
@@ -0,0 +1,108 @@
+#include "NodeNameIndex.hpp"
+#include "LevelSnapshot.hpp"
+#include <algorithm>
+
+NodeNameIndex::NodeNameIndex() : baseStore(nullptr), baseIndex(nullptr) {}
+
+NodeNameIndex::~NodeNameIndex() = default;
+
+void NodeNameIndex::attach(const LevelSnapshot& snapshot) {
+    baseStore = &snapshot.getFlatStore();
+    baseIndex = &snapshot.getNameIndex();
+    maskedBaseNodes.clear();
+    addedEntries.clear();
+    addedByPath.clear();
+    addedIndex.clear();
+}
+
+void NodeNameIndex::addNode(const std::string& path, NameId name) {
+    auto existing = addedByPath.find(path);
+    if (existing != addedByPath.end() && addedEntries[existing->second].live) {
+        return;
+    }
+
+    TrigramIndex::DocId doc = static_cast<TrigramIndex::DocId>(addedEntries.size());
+    addedEntries.push_back(Entry{ path, name, true });
+    addedByPath[path] = doc;
+    addedIndex.add(doc, NameTable::getInstance().getName(name));
+}
+
+void NodeNameIndex::removeSubtree(const FileSystemNode* node, const std::string& path) {
+    std::string buffer = path;
+    removeRecursive(node, buffer, baseStore ? baseStore->lookup(path) : FlatNodeStore::INVALID_ID);
+}
+
+std::vector<std::string> NodeNameIndex::find(const std::string& pattern) const {
+    const NameTable& names = NameTable::getInstance();
+    std::vector<std::string> results;
+
+    auto isMasked = [this](NodeId id) {
+        return id < maskedBaseNodes.size() && maskedBaseNodes[id];
+    };
+
+    if (baseStore) {
+        if (pattern.size() >= TrigramIndex::MIN_QUERY_LENGTH) {
+            for (NodeId id : baseIndex->candidates(pattern)) {
+                if (!isMasked(id) && baseStore->getName(id).find(pattern) != std::string::npos) {
+                    results.push_back(baseStore->getPath(id));
+                }
+            }
+        } else {
+            // Too short to narrow down by trigrams; fall back to the name column
+            for (NodeId id = FlatNodeStore::ROOT_ID + 1; id < baseStore->size(); ++id) {
+                if (!isMasked(id) && baseStore->getName(id).find(pattern) != std::string::npos) {
+                    results.push_back(baseStore->getPath(id));
+                }
+            }
+        }
+    }
+
+    auto matchAdded = [&](TrigramIndex::DocId doc) {
+        const Entry& entry = addedEntries[doc];
+        if (entry.live && names.getName(entry.name).find(pattern) != std::string::npos) {
+            results.push_back(entry.path);
+        }
+    };
+
+    if (pattern.size() >= TrigramIndex::MIN_QUERY_LENGTH) {
+        for (TrigramIndex::DocId doc : addedIndex.candidates(pattern)) {
+            matchAdded(doc);
+        }
+    } else {
+        for (TrigramIndex::DocId doc = 0; doc < addedEntries.size(); ++doc) {
+            matchAdded(doc);
+        }
+    }
+
+    std::sort(results.begin(), results.end());
+    return results;
+}
+
+void NodeNameIndex::removeRecursive(const FileSystemNode* node, std::string& path, NodeId baseId) {
+    // A live path is either one the session created or one from the snapshot
+    auto added = addedByPath.find(path);
+    if (added != addedByPath.end() && addedEntries[added->second].live) {
+        Entry& entry = addedEntries[added->second];
+        entry.live = false;
+        addedIndex.remove(added->second, NameTable::getInstance().getName(entry.name));
+        addedByPath.erase(added);
+    } else if (baseId != FlatNodeStore::INVALID_ID) {
+        if (maskedBaseNodes.size() < baseStore->size()) {
+            maskedBaseNodes.resize(baseStore->size(), false);
+        }
+        maskedBaseNodes[baseId] = true;
+    }
+
+    node->forEachChild([&](const FileSystemNode* child) {
+        size_t length = path.size();
+        if (path.empty() || path.back() != '/') {
+            path += '/';
+        }
+        path += child->getName();
+
+        NodeId childBaseId = (baseId != FlatNodeStore::INVALID_ID) ? baseStore->findChild(baseId, child->getNameId())
+                                                                  : FlatNodeStore::INVALID_ID;
+        removeRecursive(child, path, childBaseId);
+        path.resize(length);
+    });
+}
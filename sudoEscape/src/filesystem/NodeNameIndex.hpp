@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "FileSystemNode.hpp"
+#include "FlatNodeStore.hpp"
+#include "TrigramIndex.hpp"
+
+class LevelSnapshot;
+
+// Substring search over node names for one session. The level snapshot's
+// prebuilt trigram index covers the shared tree; this class layers the
+// session's own creations and deletions on top, so neither find nor an edit
+// ever has to rescan the whole tree.
+class NodeNameIndex {
+public:
+    NodeNameIndex();
+    ~NodeNameIndex();
+
+    // Starts over on top of snapshot, discarding every session change
+    void attach(const LevelSnapshot& snapshot);
+
+    void addNode(const std::string& path, NameId name);
+    // node is the subtree being removed and path its absolute path
+    void removeSubtree(const FileSystemNode* node, const std::string& path);
+
+    // Absolute paths of every node whose name contains pattern, sorted
+    std::vector<std::string> find(const std::string& pattern) const;
+
+private:
+    struct Entry {
+        std::string path;
+        NameId name;
+        bool live;
+    };
+
+    const FlatNodeStore* baseStore;
+    const TrigramIndex* baseIndex;
+    std::vector<bool> maskedBaseNodes;
+
+    std::vector<Entry> addedEntries;
+    std::unordered_map<std::string, TrigramIndex::DocId> addedByPath;
+    TrigramIndex addedIndex;
+
+    void removeRecursive(const FileSystemNode* node, std::string& path, NodeId baseId);
+};
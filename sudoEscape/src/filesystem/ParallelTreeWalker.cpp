@@ -0,0 +1,236 @@
+#include "ParallelTreeWalker.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+namespace {
+    struct alignas(64) WorkerQueue {
+        std::mutex mutex;
+        std::deque<const FileSystemNode*> directories;
+    };
+
+    // Directories that still have children to visit; leaves are visited
+    // inline by whoever expands their parent
+    bool needsExpanding(const FileSystemNode* node) {
+        return node->isDirectory() && node->getChildCount() > 0;
+    }
+
+    // State one parallel walk shares between its workers
+    struct SharedWalk {
+        SharedWalk(unsigned threads, const ParallelTreeWalker::Visitor& v) : visit(v), queues(threads) {}
+
+        const ParallelTreeWalker::Visitor& visit;
+        std::vector<WorkerQueue> queues;
+        // Directories queued or being expanded; the walk ends when it hits zero
+        std::atomic<size_t> pending{ 0 };
+        // Directories sitting in a queue, which idle workers wait for
+        std::atomic<size_t> queued{ 0 };
+        std::atomic<unsigned> idle{ 0 };
+        std::mutex idleMutex;
+        std::condition_variable wake;
+
+        const FileSystemNode* takeOwn(unsigned self) {
+            std::lock_guard<std::mutex> lock(queues[self].mutex);
+            if (queues[self].directories.empty()) {
+                return nullptr;
+            }
+            const FileSystemNode* node = queues[self].directories.back();
+            queues[self].directories.pop_back();
+            queued.fetch_sub(1);
+            return node;
+        }
+
+        const FileSystemNode* steal(unsigned self) {
+            const unsigned count = static_cast<unsigned>(queues.size());
+            for (unsigned offset = 1; offset < count; ++offset) {
+                WorkerQueue& victim = queues[(self + offset) % count];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (!victim.directories.empty()) {
+                    // The oldest entries sit closest to the root and carry
+                    // the most work
+                    const FileSystemNode* node = victim.directories.front();
+                    victim.directories.pop_front();
+                    queued.fetch_sub(1);
+                    return node;
+                }
+            }
+            return nullptr;
+        }
+
+        void push(unsigned self, const FileSystemNode* directory) {
+            {
+                std::lock_guard<std::mutex> lock(queues[self].mutex);
+                queues[self].directories.push_back(directory);
+            }
+            // Pairs with the idle count going up before a worker checks
+            // queued, so either it sees this directory or it gets woken
+            queued.fetch_add(1);
+            if (idle.load() > 0) {
+                std::lock_guard<std::mutex> lock(idleMutex);
+                wake.notify_one();
+            }
+        }
+
+        void work(unsigned self) {
+            while (true) {
+                const FileSystemNode* directory = takeOwn(self);
+                if (!directory) {
+                    directory = steal(self);
+                }
+                if (!directory) {
+                    std::unique_lock<std::mutex> lock(idleMutex);
+                    idle.fetch_add(1);
+                    wake.wait(lock, [this]() { return queued.load() > 0 || pending.load() == 0; });
+                    idle.fetch_sub(1);
+                    if (pending.load() == 0) {
+                        return;
+                    }
+                    continue;
+                }
+
+                visit(directory, self);
+                directory->forEachChild([&](const FileSystemNode* child) {
+                    if (needsExpanding(child)) {
+                        pending.fetch_add(1);
+                        push(self, child);
+                    } else {
+                        visit(child, self);
+                    }
+                });
+                if (pending.fetch_sub(1) == 1) {
+                    std::lock_guard<std::mutex> lock(idleMutex);
+                    wake.notify_all();
+                }
+            }
+        }
+    };
+
+    // Helper threads shared by every walker in the process, parked on
+    // jobReady between walks. There are as many as the largest walk so far
+    // needed; helper n serves as worker n, and sits a walk out if that
+    // walker has fewer workers.
+    struct Pool {
+        std::vector<std::thread> threads;
+        std::mutex mutex;
+        std::condition_variable jobReady;
+        std::condition_variable jobDone;
+        SharedWalk* job = nullptr;
+        unsigned workers = 0;
+        uint64_t generation = 0;
+        // Helpers still working on the current job
+        unsigned busy = 0;
+        bool stopping = false;
+        // Walks share the helpers, so they take turns
+        std::mutex walkMutex;
+
+        ~Pool() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            jobReady.notify_all();
+            for (auto& thread : threads) {
+                thread.join();
+            }
+        }
+
+        // Makes sure there is a helper for every worker but the caller;
+        // called with walkMutex held
+        void reserve(unsigned workers) {
+            for (unsigned worker = static_cast<unsigned>(threads.size()) + 1; worker < workers; ++worker) {
+                threads.emplace_back(&Pool::serve, this, worker);
+            }
+        }
+
+        void serve(unsigned worker) {
+            uint64_t seen = 0;
+            std::unique_lock<std::mutex> lock(mutex);
+            while (true) {
+                jobReady.wait(lock, [this, &seen]() { return stopping || generation != seen; });
+                if (stopping) {
+                    return;
+                }
+                seen = generation;
+                if (worker >= workers) {
+                    continue;
+                }
+                SharedWalk* walk = job;
+                lock.unlock();
+                walk->work(worker);
+                lock.lock();
+                if (--busy == 0) {
+                    jobDone.notify_one();
+                }
+            }
+        }
+    };
+
+    Pool& getPool() {
+        static Pool pool;
+        return pool;
+    }
+}
+
+ParallelTreeWalker::ParallelTreeWalker(unsigned threads) : threadCount(threads) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+}
+
+void ParallelTreeWalker::walk(const FileSystemNode* root, const Visitor& visit) const {
+    if (!root) {
+        return;
+    }
+
+    // Depth-first on this thread until the tree proves big enough to share
+    std::vector<const FileSystemNode*> stack{ root };
+    size_t visited = 0;
+    while (!stack.empty() && (threadCount == 1 || visited < SEQUENTIAL_THRESHOLD)) {
+        const FileSystemNode* node = stack.back();
+        stack.pop_back();
+        visit(node, 0);
+        ++visited;
+        node->forEachChild([&](const FileSystemNode* child) {
+            if (needsExpanding(child)) {
+                stack.push_back(child);
+            } else {
+                visit(child, 0);
+                ++visited;
+            }
+        });
+    }
+    if (stack.empty()) {
+        return;
+    }
+
+    Pool& pool = getPool();
+    std::lock_guard<std::mutex> walkLock(pool.walkMutex);
+    pool.reserve(threadCount);
+
+    // Deal the remaining directories out so every worker starts with some
+    SharedWalk shared(threadCount, visit);
+    for (size_t i = 0; i < stack.size(); ++i) {
+        shared.queues[i % threadCount].directories.push_back(stack[i]);
+    }
+    shared.pending.store(stack.size());
+    shared.queued.store(stack.size());
+
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.job = &shared;
+        pool.workers = threadCount;
+        pool.busy = threadCount - 1;
+        ++pool.generation;
+    }
+    pool.jobReady.notify_all();
+
+    shared.work(0);
+
+    // The shared state lives on this stack frame, so wait for every helper
+    // to let go of it
+    std::unique_lock<std::mutex> lock(pool.mutex);
+    pool.jobDone.wait(lock, [&pool]() { return pool.busy == 0; });
+    pool.job = nullptr;
+}
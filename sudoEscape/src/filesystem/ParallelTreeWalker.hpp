@@ -0,0 +1,82 @@
+#pragma once
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <vector>
+#include "FileSystemNode.hpp"
+
+// Visits every node of a subtree on several threads. Each worker owns a
+// deque of directories still to expand; it works from the back of its own
+// deque and, once that runs dry, steals from the front of another worker's,
+// so a large subtree ends up split between all idle threads. The tree must
+// not change during a walk, and visitors must not throw.
+//
+// Walks start out on the calling thread and only hand the rest of the
+// subtree to the other workers once SEQUENTIAL_THRESHOLD nodes have been
+// visited, so small trees never pay for waking them. The helper threads
+// belong to one pool for the whole process, started on the first walk that
+// needs them and asleep between walks; walks from all walkers take turns
+// on it, so a walker itself is just its thread count.
+class ParallelTreeWalker {
+public:
+    // Called once per node, root included, on any worker thread; worker is
+    // in [0, getThreadCount()) and stable for the duration of the call
+    using Visitor = std::function<void(const FileSystemNode* node, unsigned worker)>;
+
+    // threads = 0 uses one per hardware thread
+    explicit ParallelTreeWalker(unsigned threads = 0);
+
+    static constexpr size_t SEQUENTIAL_THRESHOLD = 4096;
+
+    unsigned getThreadCount() const { return threadCount; }
+
+    void walk(const FileSystemNode* root, const Visitor& visit) const;
+
+    // Gathers whatever visit(node, out) appends to out and returns it sorted
+    // by less, so the result does not depend on how the work was scheduled
+    template <typename T, typename Visit, typename Less>
+    std::vector<T> collect(const FileSystemNode* root, Visit visit, Less less) const {
+        std::vector<Slot<std::vector<T>>> parts(threadCount);
+        walk(root, [&parts, &visit](const FileSystemNode* node, unsigned worker) {
+            visit(node, parts[worker].value);
+        });
+
+        size_t total = 0;
+        for (const auto& part : parts) {
+            total += part.value.size();
+        }
+        std::vector<T> results;
+        results.reserve(total);
+        for (auto& part : parts) {
+            std::move(part.value.begin(), part.value.end(), std::back_inserter(results));
+        }
+        std::sort(results.begin(), results.end(), less);
+        return results;
+    }
+
+    // Folds map(node) over the subtree; combine must be associative and
+    // commutative since nodes are visited in no particular order
+    template <typename T, typename Map, typename Combine>
+    T reduce(const FileSystemNode* root, const T& identity, Map map, Combine combine) const {
+        std::vector<Slot<T>> parts(threadCount, Slot<T>{ identity });
+        walk(root, [&parts, &map, &combine](const FileSystemNode* node, unsigned worker) {
+            parts[worker].value = combine(parts[worker].value, map(node));
+        });
+
+        T result = identity;
+        for (const auto& part : parts) {
+            result = combine(result, part.value);
+        }
+        return result;
+    }
+
+private:
+    // Per-worker results on their own cache line, so workers never contend
+    // over each other's writes
+    template <typename T>
+    struct alignas(64) Slot {
+        T value;
+    };
+
+    unsigned threadCount;
+};
@@ -0,0 +1,62 @@
+#include "PathTable.hpp"
+#include <stdexcept>
+
+PathTable::PathTable() : count(1), generation(1) {
+    chunks[0].reset(new Entry[CHUNK_SIZE]);
+    chunks[0][ROOT_PATH].path = "/";
+}
+
+PathTable::~PathTable() = default;
+
+PathTable& PathTable::getInstance() {
+    static PathTable instance;
+    return instance;
+}
+
+PathId PathTable::intern(PathId parent, NameId name) {
+    const uint64_t key = (static_cast<uint64_t>(parent) << 32) | name;
+    {
+        std::shared_lock<std::shared_mutex> lock(tableMutex);
+        auto it = ids.find(key);
+        if (it != ids.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock<std::shared_mutex> lock(tableMutex);
+    auto it = ids.find(key);
+    if (it != ids.end()) {
+        return it->second;
+    }
+
+    uint32_t chunk = count >> CHUNK_BITS;
+    if (chunk >= MAX_CHUNKS) {
+        throw std::length_error("PathTable is full");
+    }
+    if (!chunks[chunk]) {
+        chunks[chunk].reset(new Entry[CHUNK_SIZE]);
+    }
+
+    const Entry& parentEntry = getEntry(parent);
+    const std::string& leaf = NameTable::getInstance().getName(name);
+
+    PathId id = count++;
+    Entry& entry = chunks[chunk][id & CHUNK_MASK];
+    entry.parent = parent;
+    entry.name = name;
+    entry.depth = static_cast<uint16_t>(parentEntry.depth + 1);
+    entry.path.reserve(parentEntry.path.size() + 1 + leaf.size());
+    entry.path = parentEntry.path;
+    if (parent != ROOT_PATH) {
+        entry.path += '/';
+    }
+    entry.path += leaf;
+
+    ids.emplace(key, id);
+    return id;
+}
+
+size_t PathTable::size() const {
+    std::shared_lock<std::shared_mutex> lock(tableMutex);
+    return count;
+}
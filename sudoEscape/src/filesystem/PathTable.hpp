@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include "NameTable.hpp"
+
+using PathId = uint32_t;
+
+// Process-wide table of absolute paths. A path is interned as its parent's
+// id plus its last name, so every distinct path is stored once however many
+// sessions or copies of a node sit at it, and its text is built once from
+// the parent's. Nodes cache the id of their path (see
+// FileSystemNode::getPath) and drop it lazily when the generation moves on,
+// which happens whenever a linked node is moved somewhere else.
+class PathTable {
+public:
+    // "/", the path of every root
+    static constexpr PathId ROOT_PATH = 0;
+
+    static PathTable& getInstance();
+
+    // Returns the id of the path name under parent, adding it on first use
+    PathId intern(PathId parent, NameId name);
+
+    // Lock-free: entries never move once published
+    const std::string& getPath(PathId id) const { return getEntry(id).path; }
+    uint16_t getDepth(PathId id) const { return getEntry(id).depth; }
+    PathId getParent(PathId id) const { return getEntry(id).parent; }
+    NameId getName(PathId id) const { return getEntry(id).name; }
+
+    // Cached path ids older than the current generation must be looked up
+    // again; never 0
+    uint32_t getGeneration() const { return generation.load(std::memory_order_acquire); }
+    void invalidate() { generation.fetch_add(1, std::memory_order_acq_rel); }
+
+    size_t size() const;
+
+private:
+    PathTable();
+    ~PathTable();
+    PathTable(const PathTable&) = delete;
+    PathTable& operator=(const PathTable&) = delete;
+
+    struct Entry {
+        PathId parent = ROOT_PATH;
+        NameId name = NameTable::INVALID_NAME;
+        uint16_t depth = 0;
+        std::string path;
+    };
+
+    static constexpr uint32_t CHUNK_BITS = 12;
+    static constexpr uint32_t CHUNK_SIZE = 1u << CHUNK_BITS;
+    static constexpr uint32_t CHUNK_MASK = CHUNK_SIZE - 1;
+    static constexpr uint32_t MAX_CHUNKS = 4096;
+
+    const Entry& getEntry(PathId id) const { return chunks[id >> CHUNK_BITS][id & CHUNK_MASK]; }
+
+    std::unique_ptr<Entry[]> chunks[MAX_CHUNKS];
+    // Keyed by parent id in the high half and name id in the low half
+    std::unordered_map<uint64_t, PathId> ids;
+    uint32_t count;
+    std::atomic<uint32_t> generation;
+    mutable std::shared_mutex tableMutex;
+};
@@ -0,0 +1,89 @@
+#include "TrigramIndex.hpp"
+#include <algorithm>
+#include <iterator>
+
+TrigramIndex::TrigramIndex() = default;
+
+TrigramIndex::~TrigramIndex() = default;
+
+void TrigramIndex::add(DocId doc, std::string_view text) {
+    for (uint32_t trigram : distinctTrigrams(text)) {
+        auto& list = postings[trigram];
+
+        // Documents are usually indexed in id order, making this an append
+        if (list.empty() || list.back() < doc) {
+            list.push_back(doc);
+        } else {
+            auto it = std::lower_bound(list.begin(), list.end(), doc);
+            if (it == list.end() || *it != doc) {
+                list.insert(it, doc);
+            }
+        }
+    }
+}
+
+void TrigramIndex::remove(DocId doc, std::string_view text) {
+    for (uint32_t trigram : distinctTrigrams(text)) {
+        auto found = postings.find(trigram);
+        if (found == postings.end()) continue;
+
+        auto& list = found->second;
+        auto it = std::lower_bound(list.begin(), list.end(), doc);
+        if (it != list.end() && *it == doc) {
+            list.erase(it);
+        }
+        if (list.empty()) {
+            postings.erase(found);
+        }
+    }
+}
+
+void TrigramIndex::clear() {
+    postings.clear();
+}
+
+std::vector<TrigramIndex::DocId> TrigramIndex::candidates(std::string_view pattern) const {
+    std::vector<const std::vector<DocId>*> lists;
+    for (uint32_t trigram : distinctTrigrams(pattern)) {
+        auto it = postings.find(trigram);
+        if (it == postings.end()) {
+            return {};
+        }
+        lists.push_back(&it->second);
+    }
+    if (lists.empty()) {
+        return {};
+    }
+
+    // Intersect smallest-first so the working set only shrinks
+    std::sort(lists.begin(), lists.end(), [](const std::vector<DocId>* a, const std::vector<DocId>* b) {
+        return a->size() < b->size();
+    });
+
+    std::vector<DocId> result = *lists.front();
+    std::vector<DocId> next;
+    for (size_t i = 1; i < lists.size() && !result.empty(); ++i) {
+        next.clear();
+        std::set_intersection(result.begin(), result.end(), lists[i]->begin(), lists[i]->end(),
+                              std::back_inserter(next));
+        result.swap(next);
+    }
+    return result;
+}
+
+std::vector<uint32_t> TrigramIndex::distinctTrigrams(std::string_view text) {
+    std::vector<uint32_t> trigrams;
+    if (text.size() < 3) {
+        return trigrams;
+    }
+
+    trigrams.reserve(text.size() - 2);
+    for (size_t i = 0; i + 3 <= text.size(); ++i) {
+        trigrams.push_back((static_cast<uint32_t>(static_cast<unsigned char>(text[i])) << 16) |
+                           (static_cast<uint32_t>(static_cast<unsigned char>(text[i + 1])) << 8) |
+                           static_cast<uint32_t>(static_cast<unsigned char>(text[i + 2])));
+    }
+    std::sort(trigrams.begin(), trigrams.end());
+    trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+    return trigrams;
+}
@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Inverted index from every 3-byte substring to the sorted list of documents
+// containing it. A substring query only has to intersect the posting lists of
+// its own trigrams; the caller still verifies the surviving candidates.
+class TrigramIndex {
+public:
+    using DocId = uint32_t;
+    static constexpr size_t MIN_QUERY_LENGTH = 3;
+
+    TrigramIndex();
+    ~TrigramIndex();
+
+    void add(DocId doc, std::string_view text);
+    // text must be what doc was indexed with
+    void remove(DocId doc, std::string_view text);
+    void clear();
+
+    // Documents containing every trigram of pattern, in ascending order.
+    // Only meaningful for patterns of at least MIN_QUERY_LENGTH bytes.
+    std::vector<DocId> candidates(std::string_view pattern) const;
+
+    size_t getTrigramCount() const { return postings.size(); }
+
+private:
+    std::unordered_map<uint32_t, std::vector<DocId>> postings;
+
+    static std::vector<uint32_t> distinctTrigrams(std::string_view text);
+};
@@ -0,0 +1,202 @@
+#include "VfsJournal.hpp"
+#include "../utils/Logger.hpp"
+#include "../utils/Utils.hpp"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace {
+    const char JOURNAL_MAGIC[8] = { 'S', 'U', 'D', 'O', 'J', 'R', 'N', '\0' };
+
+    // magic, format version, generation
+    constexpr size_t HEADER_SIZE = 8 + 4 + 4;
+    // op, path length, argument length, checksum
+    constexpr size_t RECORD_HEADER_SIZE = 1 + 4 + 4 + 4;
+
+    void putU32(std::string& out, uint32_t value) {
+        char bytes[4];
+        std::memcpy(bytes, &value, sizeof(bytes));
+        out.append(bytes, sizeof(bytes));
+    }
+
+    uint32_t getU32(const char* data) {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(value));
+        return value;
+    }
+}
+
+VfsJournal::VfsJournal() : generation(0), fileSize(0), deferred(false) {}
+
+VfsJournal::~VfsJournal() = default;
+
+bool VfsJournal::load(const std::string& journalPath, uint32_t& journalGeneration, std::vector<Record>& records) {
+    std::ifstream in(journalPath, std::ios::binary);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::string data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    in.close();
+
+    if (data.size() < HEADER_SIZE || std::memcmp(data.data(), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) != 0 ||
+        getU32(data.data() + 8) != FORMAT_VERSION) {
+        Logger::getInstance().log("Ignoring unreadable journal: " + journalPath);
+        return false;
+    }
+    journalGeneration = getU32(data.data() + 12);
+
+    size_t offset = HEADER_SIZE;
+    while (data.size() - offset >= RECORD_HEADER_SIZE) {
+        const char* recordHeader = data.data() + offset;
+        uint8_t op = static_cast<uint8_t>(recordHeader[0]);
+        uint32_t pathLength = getU32(recordHeader + 1);
+        uint32_t argumentLength = getU32(recordHeader + 5);
+        uint32_t expected = getU32(recordHeader + 9);
+
+        size_t remaining = data.size() - offset - RECORD_HEADER_SIZE;
+        if (op < static_cast<uint8_t>(Op::CREATE) || op > static_cast<uint8_t>(Op::MOVE) ||
+            pathLength > remaining || argumentLength > remaining - pathLength) {
+            break;
+        }
+
+        Record record;
+        record.op = static_cast<Op>(op);
+        record.path.assign(recordHeader + RECORD_HEADER_SIZE, pathLength);
+        record.argument.assign(recordHeader + RECORD_HEADER_SIZE + pathLength, argumentLength);
+        if (checksum(record.op, record.path, record.argument) != expected) {
+            break;
+        }
+
+        records.push_back(std::move(record));
+        offset += RECORD_HEADER_SIZE + pathLength + argumentLength;
+    }
+
+    if (offset != data.size()) {
+        Logger::getInstance().log("Dropping " + std::to_string(data.size() - offset) +
+                                  " damaged bytes at the end of journal: " + journalPath);
+        std::error_code error;
+        std::filesystem::resize_file(journalPath, offset, error);
+    }
+
+    path = journalPath;
+    generation = journalGeneration;
+    fileSize = offset;
+    pending.clear();
+    deferred = false;
+    return true;
+}
+
+bool VfsJournal::create(const std::string& journalPath, uint32_t journalGeneration) {
+    std::string header(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC));
+    putU32(header, FORMAT_VERSION);
+    putU32(header, journalGeneration);
+
+    // Replace the old journal atomically: a crash must leave either the old
+    // journal or the new one, never neither
+    std::string tempPath = journalPath + ".tmp";
+    std::FILE* out = std::fopen(tempPath.c_str(), "wb");
+    bool written = out && std::fwrite(header.data(), 1, header.size(), out) == header.size() &&
+                   Utils::syncFile(out);
+    if (out) {
+        written = std::fclose(out) == 0 && written;
+    }
+    if (!written) {
+        Logger::getInstance().log("Cannot create journal: " + tempPath);
+        std::error_code error;
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    std::error_code error;
+    std::filesystem::rename(tempPath, journalPath, error);
+    if (error) {
+        Logger::getInstance().log("Cannot move journal into place: " + journalPath);
+        std::filesystem::remove(tempPath, error);
+        return false;
+    }
+
+    path = journalPath;
+    generation = journalGeneration;
+    fileSize = header.size();
+    pending.clear();
+    deferred = false;
+    return true;
+}
+
+void VfsJournal::begin(const std::string& journalPath, uint32_t journalGeneration) {
+    path = journalPath;
+    generation = journalGeneration;
+    fileSize = 0;
+    pending.clear();
+    deferred = true;
+}
+
+void VfsJournal::record(Op op, const std::string& recordPath, const std::string& argument) {
+    pending.push_back(static_cast<char>(op));
+    putU32(pending, static_cast<uint32_t>(recordPath.size()));
+    putU32(pending, static_cast<uint32_t>(argument.size()));
+    putU32(pending, checksum(op, recordPath, argument));
+    pending += recordPath;
+    pending += argument;
+}
+
+bool VfsJournal::flush() {
+    if (deferred) {
+        // create() starts from an empty buffer; keep what was recorded
+        std::string buffered;
+        buffered.swap(pending);
+        bool created = create(path, generation);
+        pending.swap(buffered);
+        if (!created) {
+            return false;
+        }
+    }
+    if (pending.empty()) {
+        return true;
+    }
+    if (path.empty()) {
+        return false;
+    }
+
+    // Synced before returning, so a finished save survives a power failure
+    std::FILE* out = std::fopen(path.c_str(), "ab");
+    bool written = out && std::fwrite(pending.data(), 1, pending.size(), out) == pending.size() &&
+                   Utils::syncFile(out);
+    if (out) {
+        written = std::fclose(out) == 0 && written;
+    }
+    if (!written) {
+        // Cut off whatever part did reach the file: a retry appends the
+        // records again, and load() stops at the first torn one
+        Logger::getInstance().log("Failed writing journal: " + path);
+        std::error_code error;
+        std::filesystem::resize_file(path, fileSize, error);
+        return false;
+    }
+
+    fileSize += pending.size();
+    pending.clear();
+    return true;
+}
+
+uint32_t VfsJournal::checksum(Op op, const std::string& recordPath, const std::string& argument) {
+    // FNV-1a over the op and both strings, with their lengths mixed in so
+    // bytes cannot shift between fields unnoticed
+    uint32_t hash = 2166136261u;
+    auto mix = [&hash](const char* data, size_t length) {
+        for (size_t i = 0; i < length; ++i) {
+            hash ^= static_cast<unsigned char>(data[i]);
+            hash *= 16777619u;
+        }
+    };
+
+    char opByte = static_cast<char>(op);
+    uint32_t lengths[2] = { static_cast<uint32_t>(recordPath.size()), static_cast<uint32_t>(argument.size()) };
+    mix(&opByte, 1);
+    mix(reinterpret_cast<const char*>(lengths), sizeof(lengths));
+    mix(recordPath.data(), recordPath.size());
+    mix(argument.data(), argument.size());
+    return hash;
+}
@@ -0,0 +1,65 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Append-only log of the changes a player made to a level's file system.
+// Each record is checksummed, so a save interrupted halfway only loses the
+// records that were being written. The generation names the base the
+// records apply to: 0 is the shared level image, anything higher is a
+// compacted image of the session written by VirtualFileSystem.
+class VfsJournal {
+public:
+    static constexpr uint32_t FORMAT_VERSION = 1;
+
+    enum class Op : uint8_t {
+        CREATE = 1,
+        WRITE = 2,
+        APPEND = 3,
+        REMOVE = 4,
+        MOVE = 5
+    };
+
+    struct Record {
+        Op op;
+        std::string path;
+        // Content for CREATE/WRITE/APPEND, destination path for MOVE
+        std::string argument;
+    };
+
+    VfsJournal();
+    ~VfsJournal();
+
+    // Reads every intact record of the journal at path. A torn or corrupt
+    // tail is cut off so later appends stay readable. Returns false if there
+    // is no usable journal.
+    bool load(const std::string& path, uint32_t& generation, std::vector<Record>& records);
+    // Starts an empty journal for generation, replacing any existing file
+    bool create(const std::string& path, uint32_t generation);
+    // Like create(), but leaves any existing file alone until the first
+    // flush() replaces it, so an old journal survives until the new one is
+    // first saved
+    void begin(const std::string& path, uint32_t generation);
+
+    // Buffers a record until the next flush()
+    void record(Op op, const std::string& path, const std::string& argument = "");
+    // Appends the buffered records to the file, creating it first after
+    // begin()
+    bool flush();
+
+    const std::string& getPath() const { return path; }
+    uint32_t getGeneration() const { return generation; }
+    // Bytes on disk, not counting buffered records
+    uint64_t getFileSize() const { return fileSize; }
+    bool hasPending() const { return !pending.empty(); }
+
+private:
+    std::string path;
+    uint32_t generation;
+    uint64_t fileSize;
+    std::string pending;
+    // Set by begin() until the file has been created
+    bool deferred;
+
+    static uint32_t checksum(Op op, const std::string& path, const std::string& argument);
+};
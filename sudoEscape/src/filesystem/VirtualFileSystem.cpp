@@ -2,101 +2,154 @@
 #include "../utils/Logger.hpp"
 #include <iostream>
 #include <fstream>
+#include <filesystem>
 #include <algorithm>
 
-VirtualFileSystem::VirtualFileSystem() {
-    reset();
+VirtualFileSystem::VirtualFileSystem()
+    : root(nullptr), currentDirectory(nullptr), flatStoreDirty(true), clock(0), journaling(false), replacedGeneration(0), nextSubscription(1) {
+    static const std::shared_ptr<const LevelSnapshot> defaultSnapshot = LevelSnapshot::createDefault();
+    mountLevel(defaultSnapshot);
 }
 
 VirtualFileSystem::~VirtualFileSystem() = default;
 
 bool VirtualFileSystem::loadFromJson(const std::string& jsonFile) {
+    // Sessions on the same level share one parsed tree
+    auto snapshot = LevelSnapshotCache::getInstance().load(jsonFile);
+    if (!snapshot) {
+        return false;
+    }
+
+    mountLevel(snapshot);
+    return true;
+}
+
+bool VirtualFileSystem::saveToJson(const std::string& jsonFile) {
+    return saveTree(jsonFile, TreeFormat::JSON);
+}
+
+bool VirtualFileSystem::saveTree(const std::string& file, TreeFormat format) {
     try {
-        std::ifstream file(jsonFile);
-        if (!file.is_open()) {
-            Logger::getInstance().log("Cannot open file: " + jsonFile);
+        std::vector<uint8_t> data = encodeTree(format);
+
+        std::ofstream out(file, std::ios::binary | std::ios::trunc);
+        if (!out.is_open()) {
+            Logger::getInstance().log("Cannot create file: " + file);
             return false;
         }
+        out.write(reinterpret_cast<const char*>(data.data()), data.size());
 
-        nlohmann::json j;
-        file >> j;
-
-        initializeFromLevel(j);
-        return true;
+        return static_cast<bool>(out);
     } catch (const std::exception& e) {
-        Logger::getInstance().log("Error loading JSON: " + std::string(e.what()));
+        Logger::getInstance().log("Error saving tree: " + std::string(e.what()));
         return false;
     }
 }
 
-bool VirtualFileSystem::saveToJson(const std::string& jsonFile) {
-    try {
-        std::ofstream file(jsonFile);
-        if (!file.is_open()) {
-            Logger::getInstance().log("Cannot create file: " + jsonFile);
-            return false;
+bool VirtualFileSystem::loadTree(const std::string& file, TreeFormat format) {
+    std::ifstream in(file, std::ios::binary);
+    if (!in.is_open()) {
+        Logger::getInstance().log("Cannot open file: " + file);
+        return false;
+    }
+
+    std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    return decodeTree(data, format);
+}
+
+std::vector<uint8_t> VirtualFileSystem::encodeTree(TreeFormat format) {
+    nlohmann::json document;
+    document["version"] = 1;
+    document["start_location"] = baseSnapshot->getStartLocation();
+    document["clock"] = clock;
+    document["root"] = nodeToJson(root);
+
+    switch (format) {
+        case TreeFormat::CBOR:
+            return nlohmann::json::to_cbor(document);
+        case TreeFormat::MESSAGEPACK:
+            return nlohmann::json::to_msgpack(document);
+        case TreeFormat::JSON:
+        default: {
+            std::string text = document.dump(4);
+            return std::vector<uint8_t>(text.begin(), text.end());
         }
+    }
+}
 
-        nlohmann::json j = nodeToJson(root);
-        file << j.dump(4);
+bool VirtualFileSystem::decodeTree(const std::vector<uint8_t>& data, TreeFormat format) {
+    try {
+        nlohmann::json document;
+        switch (format) {
+            case TreeFormat::CBOR: document = nlohmann::json::from_cbor(data); break;
+            case TreeFormat::MESSAGEPACK: document = nlohmann::json::from_msgpack(data); break;
+            case TreeFormat::JSON:
+            default: document = nlohmann::json::parse(data.begin(), data.end()); break;
+        }
 
+        auto snapshot = LevelSnapshot::fromTree(document);
+        if (!snapshot) {
+            return false;
+        }
+        mountLevel(snapshot);
         return true;
     } catch (const std::exception& e) {
-        Logger::getInstance().log("Error saving JSON: " + std::string(e.what()));
+        Logger::getInstance().log("Error loading tree: " + std::string(e.what()));
         return false;
     }
 }
 
 void VirtualFileSystem::initializeFromLevel(const nlohmann::json& levelData) {
-    reset();
-
-    if (levelData.contains("locations")) {
-        const auto& locations = levelData["locations"];
-
-        for (const auto& [locationName, locationData] : locations.items()) {
-            auto location = std::make_shared<FileSystemNode>(locationName, NodeType::DIRECTORY);
-            root->addChild(location);
+    mountLevel(LevelSnapshot::fromJson(levelData));
+}
 
-            createDirectoryStructure(location, locationData);
+bool VirtualFileSystem::openJournal(const std::string& prefix, bool resume) {
+    savePrefix = prefix;
+    journaling = false;
+    std::string journalPath = savePrefix + ".journal";
+
+    uint32_t generation = 0;
+    std::vector<VfsJournal::Record> records;
+    if (resume && journal.load(journalPath, generation, records)) {
+        // A journal past generation 0 continues a compacted image instead of
+        // the shared level
+        std::shared_ptr<const LevelImage> base;
+        if (generation == 0 || (base = LevelImage::open(getBaseImagePath(generation)))) {
+            if (base) {
+                mount(LevelSnapshot::fromImage(base));
+            }
+            replayJournal(records);
+            journaling = true;
+            return true;
         }
+        Logger::getInstance().log("Saved file system base is missing, starting over: " + getBaseImagePath(generation));
     }
 
-    // Set current directory to starting location
-    std::string startLocation = "desktop";
-    if (levelData.contains("level_info") && levelData["level_info"].contains("starting_location")) {
-        startLocation = levelData["level_info"]["starting_location"];
+    // Leave the previous save alone until this one is first saved, so
+    // quitting a new game before then does not lose it
+    replacedGeneration = 0;
+    if (!resume && journal.load(journalPath, generation, records)) {
+        replacedGeneration = generation;
     }
-
-    changeDirectory(startLocation);
+    journal.begin(journalPath, 0);
+    journaling = true;
+    return true;
 }
 
-bool VirtualFileSystem::changeDirectory(const std::string& path) {
-    if (path.empty()) {
+bool VirtualFileSystem::saveChanges() {
+    if (!journaling || !journal.flush()) {
         return false;
     }
-
-    std::shared_ptr<FileSystemNode> target = nullptr;
-
-    // Handle absolute paths
-    if (path[0] == '/') {
-        target = root;
-        // Parse path components
-        std::string remainingPath = path.substr(1);
-        // For simplicity, we'll just handle single directory names
-        if (!remainingPath.empty()) {
-            target = root->getChild(remainingPath);
-        }
-    } else {
-        // Handle relative paths
-        if (path == "..") {
-            target = currentDirectory->getParent();
-            if (!target) {
-                target = root;
-            }
-        } else {
-            target = currentDirectory->getChild(path);
-        }
+    if (replacedGeneration > 0) {
+        std::error_code error;
+        std::filesystem::remove(getBaseImagePath(replacedGeneration), error);
+        replacedGeneration = 0;
     }
+    return journal.getFileSize() < COMPACTION_THRESHOLD || compactJournal();
+}
+
+bool VirtualFileSystem::changeDirectory(const std::string& path) {
+    FileSystemNode* target = resolvePath(path);
 
     if (target && target->isDirectory()) {
         directoryStack.push(currentDirectory);
@@ -112,13 +165,16 @@ bool VirtualFileSystem::goBack() {
         return false;
     }
 
-    currentDirectory = directoryStack.top();
+    FileSystemNode* previous = currentVersionOf(directoryStack.top());
     directoryStack.pop();
+    if (previous) {
+        currentDirectory = previous;
+    }
     return true;
 }
 
-std::string VirtualFileSystem::getCurrentPath() const {
-    return getNodePath(currentDirectory);
+const std::string& VirtualFileSystem::getCurrentPath() const {
+    return currentDirectory->getPath();
 }
 
 std::vector<FileSystemItem> VirtualFileSystem::listCurrentDirectory(bool showHidden) const {
@@ -126,181 +182,774 @@ std::vector<FileSystemItem> VirtualFileSystem::listCurrentDirectory(bool showHid
 }
 
 std::string VirtualFileSystem::readFile(const std::string& filename) const {
-    auto file = currentDirectory->getChild(filename);
+    auto file = resolvePath(filename);
     if (file && file->isFile()) {
         return file->getContent();
     }
     return "";
 }
 
+std::vector<FileSystemItem> VirtualFileSystem::listMatching(const std::string& pattern, bool showHidden) const {
+    if (!GlobPattern::hasWildcards(pattern)) {
+        auto node = resolvePath(pattern);
+        if (node && node->isDirectory()) {
+            return node->listItems(showHidden);
+        }
+    }
+
+    std::vector<FileSystemItem> items;
+    std::string leaf;
+    auto directory = resolveParent(pattern, leaf);
+    if (!directory || !directory->isDirectory()) {
+        return items;
+    }
+
+    GlobPattern glob(leaf);
+    for (const FileSystemNode* child : directory->getSortedChildren()) {
+        if (glob.matchesName(child->getName())) {
+            items.emplace_back(child->getName(), child->getType(), child->getSize(), child->getMetadata());
+        }
+    }
+    return items;
+}
+
+const FileContent* VirtualFileSystem::getFileContent(const std::string& filename) const {
+    auto file = resolvePath(filename);
+    return (file && file->isFile()) ? &file->getFileContent() : nullptr;
+}
+
 bool VirtualFileSystem::writeFile(const std::string& filename, const std::string& content) {
-    auto file = currentDirectory->getChild(filename);
-    if (file && file->isFile()) {
+    auto file = resolvePath(filename);
+    if (file && file->isFile() && (file = makeWritable(file))) {
+        contentIndex.updateFile(file->getPath(), file->getFileContent(), content);
         file->setContent(content);
+        file->touch(++clock);
+        if (journaling) {
+            journal.record(VfsJournal::Op::WRITE, file->getPath(), content);
+        }
+        notify(VfsChange::Kind::WRITE, file->getPath());
+        return true;
+    }
+    return false;
+}
+
+bool VirtualFileSystem::appendFile(const std::string& filename, const std::string& content) {
+    auto file = resolvePath(filename);
+    if (file && file->isFile() && (file = makeWritable(file))) {
+        contentIndex.appendFile(file->getPath(), file->getFileContent(), content);
+        file->appendContent(content);
+        file->touch(++clock);
+        if (journaling) {
+            journal.record(VfsJournal::Op::APPEND, file->getPath(), content);
+        }
+        notify(VfsChange::Kind::APPEND, file->getPath());
         return true;
     }
     return false;
 }
 
 bool VirtualFileSystem::createFile(const std::string& filename, const std::string& content) {
-    if (currentDirectory->getChild(filename)) {
-        return false; // File already exists
+    std::string name;
+    auto directory = resolveParent(filename, name);
+    if (!directory || !directory->isDirectory() || directory->getChild(name) ||
+        !(directory = makeWritable(directory))) {
+        return false; // Missing parent or file already exists
     }
 
-    auto newFile = std::make_shared<FileSystemNode>(filename, NodeType::FILE, content);
-    currentDirectory->addChild(newFile);
+    auto newFile = arena.create(name, NodeType::FILE, content);
+    directory->addChild(newFile);
+    newFile->touch(++clock);
+    directory->touch(clock);
+    const std::string& path = newFile->getPath();
+    nameIndex.addNode(path, newFile->getNameId());
+    contentIndex.addFile(path, content);
+    if (journaling) {
+        journal.record(VfsJournal::Op::CREATE, path, content);
+    }
+    markStructureChanged();
+    notify(VfsChange::Kind::CREATE, path);
     return true;
 }
 
 bool VirtualFileSystem::deleteFile(const std::string& filename) {
-    auto file = currentDirectory->getChild(filename);
-    if (file) {
-        currentDirectory->removeChild(filename);
+    std::string name;
+    auto directory = resolveParent(filename, name);
+    auto file = directory ? directory->getChild(name) : nullptr;
+
+    // Never pull the current directory out from under the player
+    if (file && !containsCurrentDirectory(file) && (directory = makeWritable(directory))) {
+        // Interned, so it stays valid for the listeners once the node is gone
+        const std::string& path = file->getPath();
+        nameIndex.removeSubtree(file, path);
+        contentIndex.removeSubtree(file, path);
+        if (journaling) {
+            journal.record(VfsJournal::Op::REMOVE, path);
+        }
+        directory->removeChild(name);
+        directory->touch(++clock);
+        markStructureChanged();
+        notify(VfsChange::Kind::REMOVE, path);
         return true;
     }
     return false;
 }
 
+size_t VirtualFileSystem::deleteMatching(const std::string& pattern) {
+    std::string leaf;
+    auto directory = resolveParent(pattern, leaf);
+    if (!directory || !directory->isDirectory()) {
+        return 0;
+    }
+
+    // Collect first: deleting copies the directory on write
+    GlobPattern glob(leaf);
+    std::string prefix = directory->getPath();
+    if (prefix.back() != '/') {
+        prefix += '/';
+    }
+    std::vector<std::string> matches;
+    for (const FileSystemNode* child : directory->getSortedChildren()) {
+        if (glob.matchesName(child->getName())) {
+            matches.push_back(prefix + child->getName());
+        }
+    }
+
+    size_t deleted = 0;
+    for (const auto& path : matches) {
+        if (deleteFile(path)) {
+            ++deleted;
+        }
+    }
+    return deleted;
+}
+
+bool VirtualFileSystem::moveFile(const std::string& source, const std::string& destination) {
+    std::string name;
+    auto sourceDirectory = resolveParent(source, name);
+    auto node = sourceDirectory ? sourceDirectory->getChild(name) : nullptr;
+    if (!node || containsCurrentDirectory(node)) {
+        return false;
+    }
+
+    std::string newName;
+    FileSystemNode* targetDirectory = resolvePath(destination);
+    if (targetDirectory && targetDirectory->isDirectory()) {
+        newName = name;
+    } else {
+        targetDirectory = resolveParent(destination, newName);
+    }
+    if (!targetDirectory || !targetDirectory->isDirectory() || targetDirectory->getChild(newName) ||
+        isWithin(targetDirectory, node)) {
+        return false; // Missing target, name taken, or a directory moving below itself
+    }
+
+    // Copying one directory up never replaces the other's writable copy, so
+    // both stay valid once made
+    sourceDirectory = makeWritable(sourceDirectory);
+    targetDirectory = sourceDirectory ? makeWritable(targetDirectory) : nullptr;
+    if (!targetDirectory) {
+        return false;
+    }
+
+    const std::string& oldPath = node->getPath();
+    nameIndex.removeSubtree(node, oldPath);
+    contentIndex.removeSubtree(node, oldPath);
+
+    // Shared nodes keep their snapshot location in parent links, so the
+    // moved subtree becomes private to the session first
+    node = thawSubtree(sourceDirectory, sourceDirectory->getChild(name));
+    sourceDirectory->removeChild(name);
+
+    node->setName(newName);
+    targetDirectory->addChild(node);
+
+    // Renaming changes the node's inode, not its contents
+    ++clock;
+    node->setTimes(node->getMetadata().modifiedTime, clock);
+    sourceDirectory->touch(clock);
+    targetDirectory->touch(clock);
+
+    indexSubtree(node);
+    if (journaling) {
+        journal.record(VfsJournal::Op::MOVE, oldPath, node->getPath());
+    }
+    markStructureChanged();
+    notify(VfsChange::Kind::MOVE, oldPath, node->getPath());
+    return true;
+}
+
 std::vector<std::string> VirtualFileSystem::findFiles(const std::string& pattern) const {
-    std::vector<std::string> results;
-    findFilesRecursive(root, pattern, results, "");
-    return results;
+    const FileSystemNode* top = root;
+
+    if (GlobPattern::hasWildcards(pattern)) {
+        GlobPattern glob(pattern);
+        return treeWalker.collect<std::string>(top,
+            [top, &glob](const FileSystemNode* node, std::vector<std::string>& out) {
+                if (node == top) {
+                    return;
+                }
+                const std::string& path = node->getPath();
+                if (glob.isPathPattern() ? glob.matchesPath(path) : glob.matchesName(node->getName())) {
+                    out.push_back(path);
+                }
+            },
+            std::less<std::string>());
+    }
+
+    if (pattern.size() >= TrigramIndex::MIN_QUERY_LENGTH) {
+        return nameIndex.find(pattern);
+    }
+
+    // Too short for trigrams, so every name has to be checked anyway
+    return treeWalker.collect<std::string>(top,
+        [top, &pattern](const FileSystemNode* node, std::vector<std::string>& out) {
+            if (node != top && node->getName().find(pattern) != std::string_view::npos) {
+                out.push_back(node->getPath());
+            }
+        },
+        std::less<std::string>());
 }
 
 bool VirtualFileSystem::fileExists(const std::string& filename) const {
-    return currentDirectory->getChild(filename) != nullptr;
+    return resolvePath(filename) != nullptr;
+}
+
+std::vector<GrepMatch> VirtualFileSystem::grepFiles(const std::string& pattern, const std::string& directory) const {
+    std::vector<GrepMatch> matches;
+
+    auto scope = resolvePath(directory);
+    if (!scope || pattern.empty()) {
+        return matches;
+    }
+
+    std::string prefix = scope->getPath();
+    if (prefix.back() != '/') {
+        prefix += '/';
+    }
+
+    auto grepLines = [&pattern](const FileSystemNode* file, std::vector<GrepMatch>& out) {
+        // Only files with a match need their path built
+        std::string path;
+        size_t lineNumber = 0;
+        file->getFileContent().forEachLine([&](std::string_view line) {
+            ++lineNumber;
+            if (line.find(pattern) != std::string_view::npos) {
+                if (path.empty()) {
+                    path = file->getPath();
+                }
+                out.push_back(GrepMatch{ path, lineNumber, std::string(line) });
+            }
+            return true;
+        });
+    };
+
+    if (pattern.size() < TrigramIndex::MIN_QUERY_LENGTH) {
+        // Every file is a candidate, so scan the scope directly and spread
+        // the files over all cores
+        return treeWalker.collect<GrepMatch>(scope,
+            [&grepLines](const FileSystemNode* node, std::vector<GrepMatch>& out) {
+                if (node->isFile()) {
+                    grepLines(node, out);
+                }
+            },
+            [](const GrepMatch& a, const GrepMatch& b) {
+                int order = a.path.compare(b.path);
+                return order != 0 ? order < 0 : a.lineNumber < b.lineNumber;
+            });
+    }
+
+    // The index narrows the search to files holding all of the pattern's
+    // trigrams; only those are opened and split into lines
+    for (const auto& path : contentIndex.candidates(pattern)) {
+        if (path.compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+
+        // Walked without going through resolvePath, so a broad search does
+        // not flush the dentry cache with one-off entries
+        unsigned hops = 0;
+        auto file = walkPath(root, path, nullptr, false, hops);
+        if (!file || !file->isFile()) {
+            continue;
+        }
+
+        grepLines(file, matches);
+    }
+
+    return matches;
+}
+
+bool VirtualFileSystem::getTreeUsage(const std::string& directory, TreeUsage& usage) const {
+    auto scope = resolvePath(directory);
+    if (!scope) {
+        return false;
+    }
+
+    usage = treeWalker.reduce(scope, TreeUsage(),
+        [](const FileSystemNode* node) {
+            TreeUsage single;
+            if (node->isDirectory()) {
+                single.directories = 1;
+            } else {
+                single.files = 1;
+                single.bytes = node->getFileContent().size();
+                single.storedBytes = node->getFileContent().getStoredSize();
+            }
+            return single;
+        },
+        [](const TreeUsage& a, const TreeUsage& b) {
+            TreeUsage sum;
+            sum.files = a.files + b.files;
+            sum.directories = a.directories + b.directories;
+            sum.bytes = a.bytes + b.bytes;
+            sum.storedBytes = a.storedBytes + b.storedBytes;
+            return sum;
+        });
+    return true;
+}
+
+FileSystemNode* VirtualFileSystem::resolvePath(const std::string& path, bool followShortcut) const {
+    if (path.empty()) {
+        return nullptr;
+    }
+
+    FileSystemNode* start = (path[0] == '/') ? root : currentDirectory;
+    unsigned hops = 0;
+
+    // Single names are one hash lookup already (plus the shortcut cache if
+    // they name a shortcut); only cache deeper walks
+    if (path.find('/') == std::string::npos) {
+        return walkPath(start, path, nullptr, followShortcut, hops);
+    }
+
+    DentryKey key{ start, path, followShortcut };
+    auto it = dentryCache.find(key);
+    if (it != dentryCache.end()) {
+        if (isCurrent(it->second.dependencies)) {
+            return it->second.target;
+        }
+        dentryCache.erase(it);
+    }
+
+    DentryEntry entry;
+    entry.target = walkPath(start, path, &entry.dependencies, followShortcut, hops);
+    FileSystemNode* target = entry.target;
+
+    if (dentryCache.size() >= DENTRY_CACHE_LIMIT) {
+        dentryCache.clear();
+    }
+    dentryCache.emplace(std::move(key), std::move(entry));
+    return target;
 }
 
 void VirtualFileSystem::printTree() const {
     std::cout << "File System Tree:\n";
-    printTreeRecursive(root, "");
+
+    const FlatNodeStore& store = getFlatStore();
+    if (store.empty()) return;
+
+    // Depth-first over the child ranges, pushing children in reverse so they
+    // print in name order
+    std::vector<std::pair<NodeId, size_t>> pending = { { FlatNodeStore::ROOT_ID, 0 } };
+    while (!pending.empty()) {
+        auto [id, depth] = pending.back();
+        pending.pop_back();
+
+        std::cout << std::string(depth * 2, ' ') << store.getName(id);
+        if (store.getType(id) == NodeType::DIRECTORY) {
+            std::cout << "/";
+        }
+        std::cout << "\n";
+
+        NodeId first = store.getFirstChild(id);
+        for (uint32_t i = store.getChildCount(id); i > 0; --i) {
+            pending.emplace_back(first + i - 1, depth + 1);
+        }
+    }
 }
 
 void VirtualFileSystem::reset() {
-    root = std::make_shared<FileSystemNode>("root", NodeType::DIRECTORY);
-    currentDirectory = root;
+    bool wasJournaling = journaling;
+    mount(levelSnapshot);
+    if (wasJournaling) {
+        openJournal(savePrefix, false);
+    }
+}
+
+VirtualFileSystem::SubscriptionId VirtualFileSystem::subscribe(ChangeListener listener) {
+    SubscriptionId id = nextSubscription++;
+    listeners.emplace_back(id, std::move(listener));
+    return id;
+}
+
+void VirtualFileSystem::unsubscribe(SubscriptionId id) {
+    listeners.erase(std::remove_if(listeners.begin(), listeners.end(),
+                                   [id](const auto& entry) { return entry.first == id; }),
+                    listeners.end());
+}
+
+void VirtualFileSystem::notify(VfsChange::Kind kind, std::string_view path, std::string_view newPath) const {
+    if (listeners.empty()) {
+        return;
+    }
+    VfsChange change{ kind, path, newPath };
+    for (const auto& entry : listeners) {
+        entry.second(change);
+    }
+}
+
+void VirtualFileSystem::mount(std::shared_ptr<const LevelSnapshot> snapshot) {
+    // Dropping the arena frees every node this session copied in one go
+    arena.release();
+    baseSnapshot = std::move(snapshot);
+    root = baseSnapshot->getRoot();
+    clock = baseSnapshot->getClock();
+    nameIndex.attach(*baseSnapshot);
+    contentIndex.attach(*baseSnapshot);
+
+    currentDirectory = getStartDirectory();
     while (!directoryStack.empty()) {
         directoryStack.pop();
     }
 
-    initializeDefaultStructure();
+    dentryCache.clear();
+    shortcutCache.clear();
+    markStructureChanged();
+
+    // A journal only describes changes to the tree it was opened on
+    journaling = false;
+    notify(VfsChange::Kind::RESET, root->getPath());
+}
+
+void VirtualFileSystem::mountLevel(std::shared_ptr<const LevelSnapshot> snapshot) {
+    levelSnapshot = snapshot;
+    mount(std::move(snapshot));
 }
 
-void VirtualFileSystem::initializeDefaultStructure() {
-    // Create desktop directory
-    auto desktop = std::make_shared<FileSystemNode>("desktop", NodeType::DIRECTORY);
-    root->addChild(desktop);
+FileSystemNode* VirtualFileSystem::getStartDirectory() const {
+    auto start = root->getChild(baseSnapshot->getStartLocation());
+    return (start && start->isDirectory()) ? start : root;
+}
+
+void VirtualFileSystem::replayJournal(const std::vector<VfsJournal::Record>& records) {
+    // Replay from the root so no deletion is refused because of where the
+    // player happens to stand
+    currentDirectory = root;
+
+    size_t applied = 0;
+    for (const auto& record : records) {
+        bool ok = false;
+        switch (record.op) {
+            case VfsJournal::Op::CREATE: ok = createFile(record.path, record.argument); break;
+            case VfsJournal::Op::WRITE: ok = writeFile(record.path, record.argument); break;
+            case VfsJournal::Op::APPEND: ok = appendFile(record.path, record.argument); break;
+            case VfsJournal::Op::REMOVE: ok = deleteFile(record.path); break;
+            case VfsJournal::Op::MOVE: ok = moveFile(record.path, record.argument); break;
+        }
+        if (ok) {
+            ++applied;
+        }
+    }
+
+    currentDirectory = getStartDirectory();
+    Logger::getInstance().log("Replayed " + std::to_string(applied) + " of " + std::to_string(records.size()) +
+                              " journal records");
+}
 
-    // Create basic shortcuts on desktop
-    auto myComputer = std::make_shared<FileSystemNode>("My Computer", NodeType::SHORTCUT, "System Information");
-    auto fileExplorer = std::make_shared<FileSystemNode>("File Explorer", NodeType::SHORTCUT, "File Browser");
+bool VirtualFileSystem::compactJournal() {
+    // Write the new base before switching the journal over to it, so a crash
+    // in between still leaves the old base and journal intact
+    uint32_t previous = journal.getGeneration();
+    uint32_t next = previous + 1;
+    if (!LevelImage::compile(getFlatStore(), baseSnapshot->getStartLocation(), clock, 0, getBaseImagePath(next)) ||
+        !journal.create(savePrefix + ".journal", next)) {
+        return false;
+    }
 
-    desktop->addChild(myComputer);
-    desktop->addChild(fileExplorer);
+    if (previous > 0) {
+        std::error_code error;
+        std::filesystem::remove(getBaseImagePath(previous), error);
+    }
+    Logger::getInstance().log("Compacted file system journal into " + getBaseImagePath(next));
+    return true;
+}
 
-    currentDirectory = desktop;
+std::string VirtualFileSystem::getBaseImagePath(uint32_t generation) const {
+    return savePrefix + "." + std::to_string(generation) + ".lvl";
 }
 
-void VirtualFileSystem::createDirectoryStructure(std::shared_ptr<FileSystemNode> parent, const nlohmann::json& locationData) {
-    if (locationData.contains("items")) {
-        for (const auto& item : locationData["items"]) {
-            std::string name = item.value("name", "");
-            std::string type = item.value("type", "file");
-            std::string content = item.value("content", "");
+FileSystemNode* VirtualFileSystem::makeWritable(FileSystemNode* node) {
+    if (!node->isFrozen()) {
+        return node;
+    }
 
-            NodeType nodeType = (type == "folder") ? NodeType::DIRECTORY : 
-                               (type == "shortcut") ? NodeType::SHORTCUT : NodeType::FILE;
+    // Path copying: clone every shared node from the root down to the target,
+    // re-linking each clone into its freshly copied parent
+    std::vector<NameId> path = getNamePath(node);
 
-            auto child = std::make_shared<FileSystemNode>(name, nodeType, content);
-            parent->addChild(child);
+    if (root->isFrozen()) {
+        root = arena.create(*root);
+    }
+
+    // Cached walks may have gone through nodes that are about to be replaced
+    dentryCache.clear();
+    shortcutCache.clear();
+
+    FileSystemNode* current = root;
+    for (NameId name : path) {
+        FileSystemNode* child = current->getChild(name);
+        if (!child) {
+            // The session has since removed it or one of its ancestors
+            current = nullptr;
+            break;
+        }
+        if (child->isFrozen()) {
+            child = arena.create(*child);
+            current->addChild(child);
+        }
+        current = child;
+    }
+
+    if (auto cwd = currentVersionOf(currentDirectory)) {
+        currentDirectory = cwd;
+    }
+    markStructureChanged();
+    return current;
+}
 
-            // If it's a directory and has nested items, create them recursively
-            if (nodeType == NodeType::DIRECTORY && item.contains("items")) {
-                createDirectoryStructure(child, item);
+FileSystemNode* VirtualFileSystem::currentVersionOf(FileSystemNode* node) const {
+    if (!node || !node->isFrozen() || root->isFrozen()) {
+        return node;
+    }
+
+    FileSystemNode* current = root;
+    for (NameId name : getNamePath(node)) {
+        current = current->getChild(name);
+        if (!current) {
+            return nullptr;
+        }
+    }
+    return current;
+}
+
+FileSystemNode* VirtualFileSystem::walkPath(FileSystemNode* start, std::string_view path, Dependencies* dependencies,
+                                            bool followShortcut, unsigned& hops) const {
+    // Nodes entered on the way down, so ".." can step back without going
+    // through (possibly shared) parent links
+    std::vector<FileSystemNode*> visited;
+    FileSystemNode* current = start;
+
+    size_t pos = 0;
+    while (current && pos <= path.size()) {
+        size_t end = path.find('/', pos);
+        if (end == std::string_view::npos) {
+            end = path.size();
+        }
+        std::string_view component = path.substr(pos, end - pos);
+        pos = end + 1;
+
+        if (component.empty() || component == ".") {
+            continue;
+        }
+
+        if (component == "..") {
+            if (!visited.empty()) {
+                current = visited.back();
+                visited.pop_back();
+            } else if (current != root) {
+                if (dependencies) {
+                    dependencies->emplace_back(current, current->getVersion());
+                }
+                current = currentVersionOf(current->getParent());
+                if (!current) {
+                    current = root;
+                }
             }
+            continue;
+        }
+
+        if (!current->isDirectory()) {
+            return nullptr;
+        }
+        if (dependencies) {
+            dependencies->emplace_back(current, current->getVersion());
+        }
+
+        visited.push_back(current);
+        current = current->getChild(component);
+
+        // pos is past the end only after the last component; a trailing
+        // slash counts as going through
+        if (current && current->isShortcut() && (followShortcut || pos <= path.size())) {
+            current = this->followShortcut(visited.back(), current, dependencies, hops);
+            // ".." from the target goes to its real parent, not back here
+            visited.clear();
         }
     }
+
+    return current;
 }
 
-void VirtualFileSystem::findFilesRecursive(std::shared_ptr<FileSystemNode> node, const std::string& pattern, 
-                                         std::vector<std::string>& results, const std::string& currentPath) const {
-    if (!node) return;
+FileSystemNode* VirtualFileSystem::followShortcut(FileSystemNode* directory, const FileSystemNode* shortcut,
+                                                  Dependencies* dependencies, unsigned& hops) const {
+    auto it = shortcutCache.find(shortcut);
+    bool cached = it != shortcutCache.end() && isCurrent(it->second.dependencies);
+    hops += cached ? it->second.hops : 1;
+    if (hops > MAX_SHORTCUT_HOPS) {
+        Logger::getInstance().log("Too many levels of shortcuts at " + shortcut->getPath());
+        return nullptr;
+    }
 
-    std::string nodePath = currentPath + "/" + node->getName();
+    if (cached) {
+        if (dependencies) {
+            dependencies->insert(dependencies->end(), it->second.dependencies.begin(), it->second.dependencies.end());
+        }
+        return it->second.target;
+    }
+    if (it != shortcutCache.end()) {
+        shortcutCache.erase(it);
+    }
 
-    if (node->getName().find(pattern) != std::string::npos) {
-        results.push_back(nodePath);
+    std::string scratch;
+    std::string_view target = shortcut->getFileContent().flatten(scratch);
+    if (target.empty()) {
+        return nullptr;
     }
 
-    if (node->isDirectory()) {
-        for (const auto& child : node->getChildren()) {
-            findFilesRecursive(child, pattern, results, nodePath);
+    ShortcutTarget entry;
+    unsigned before = hops;
+    entry.target = walkPath(target[0] == '/' ? root : directory, target, &entry.dependencies, true, hops);
+    entry.hops = hops - before + 1;
+    FileSystemNode* resolved = entry.target;
+
+    // Chains tend to stay within a few directories
+    std::sort(entry.dependencies.begin(), entry.dependencies.end());
+    entry.dependencies.erase(std::unique(entry.dependencies.begin(), entry.dependencies.end()),
+                             entry.dependencies.end());
+    if (dependencies) {
+        dependencies->insert(dependencies->end(), entry.dependencies.begin(), entry.dependencies.end());
+    }
+
+    if (resolved) {
+        if (shortcutCache.size() >= DENTRY_CACHE_LIMIT) {
+            shortcutCache.clear();
         }
+        shortcutCache.emplace(shortcut, std::move(entry));
     }
+    return resolved;
 }
 
-std::string VirtualFileSystem::getNodePath(std::shared_ptr<FileSystemNode> node) const {
-    if (!node || node == root) {
-        return "/";
+bool VirtualFileSystem::isCurrent(const Dependencies& dependencies) {
+    for (const auto& [directory, version] : dependencies) {
+        if (directory->getVersion() != version) {
+            return false;
+        }
     }
+    return true;
+}
 
-    std::string path = "";
-    std::shared_ptr<FileSystemNode> current = node;
+FileSystemNode* VirtualFileSystem::resolveParent(const std::string& path, std::string& leafName) const {
+    size_t end = path.find_last_not_of('/');
+    if (end == std::string::npos) {
+        return nullptr;
+    }
 
-    while (current && current != root) {
-        path = "/" + current->getName() + path;
-        current = current->getParent();
+    size_t slash = path.rfind('/', end);
+    size_t begin = (slash == std::string::npos) ? 0 : slash + 1;
+    leafName = path.substr(begin, end - begin + 1);
+    if (leafName == "." || leafName == "..") {
+        return nullptr;
     }
 
-    return path.empty() ? "/" : path;
+    if (slash == std::string::npos) {
+        return currentDirectory;
+    }
+    return slash == 0 ? root : resolvePath(path.substr(0, slash));
 }
 
-void VirtualFileSystem::printTreeRecursive(std::shared_ptr<FileSystemNode> node, const std::string& prefix) const {
-    if (!node) return;
+bool VirtualFileSystem::containsCurrentDirectory(const FileSystemNode* node) const {
+    return isWithin(currentDirectory, node);
+}
 
-    std::cout << prefix << node->getName();
-    if (node->isDirectory()) {
-        std::cout << "/";
+bool VirtualFileSystem::isWithin(const FileSystemNode* node, const FileSystemNode* ancestor) {
+    // Compared by interned paths, since shared nodes link to their snapshot
+    // parents rather than to the session's copies
+    const PathTable& paths = PathTable::getInstance();
+    PathId path = node->getPathId();
+    const PathId prefix = ancestor->getPathId();
+    for (uint16_t depth = paths.getDepth(path); depth > paths.getDepth(prefix); --depth) {
+        path = paths.getParent(path);
     }
-    std::cout << "\n";
+    return path == prefix;
+}
 
-    if (node->isDirectory()) {
-        for (const auto& child : node->getChildren()) {
-            printTreeRecursive(child, prefix + "  ");
-        }
+std::vector<NameId> VirtualFileSystem::getNamePath(const FileSystemNode* node) {
+    if (!node) {
+        return {};
+    }
+    const PathTable& paths = PathTable::getInstance();
+    PathId id = node->getPathId();
+    std::vector<NameId> path(paths.getDepth(id));
+    for (size_t index = path.size(); index > 0; id = paths.getParent(id)) {
+        path[--index] = paths.getName(id);
     }
+    return path;
 }
 
-nlohmann::json VirtualFileSystem::nodeToJson(std::shared_ptr<FileSystemNode> node) const {
-    nlohmann::json j;
+FileSystemNode* VirtualFileSystem::thawSubtree(FileSystemNode* parent, FileSystemNode* node) {
+    if (node->isFrozen()) {
+        node = arena.create(*node);
+        parent->addChild(node);
+    }
+    for (FileSystemNode* child : node->getChildren()) {
+        thawSubtree(node, child);
+    }
+    return node;
+}
 
-    j["name"] = node->getName();
-    j["type"] = node->isDirectory() ? "directory" : "file";
-    j["content"] = node->getContent();
+void VirtualFileSystem::indexSubtree(const FileSystemNode* node) {
+    nameIndex.addNode(node->getPath(), node->getNameId());
+    if (node->isFile()) {
+        std::string scratch;
+        contentIndex.addFile(node->getPath(), node->getFileContent().flatten(scratch));
+    }
+    node->forEachChild([this](const FileSystemNode* child) { indexSubtree(child); });
+}
 
-    if (node->isDirectory()) {
-        j["children"] = nlohmann::json::array();
-        for (const auto& child : node->getChildren()) {
-            j["children"].push_back(nodeToJson(child));
-        }
+const FlatNodeStore& VirtualFileSystem::getFlatStore() const {
+    // Until the session writes anything, the snapshot's store is exact
+    if (root->isFrozen()) {
+        return baseSnapshot->getFlatStore();
     }
 
-    return j;
+    if (flatStoreDirty) {
+        flatStore.build(root);
+        flatStoreDirty = false;
+    }
+    return flatStore;
 }
 
-std::shared_ptr<FileSystemNode> VirtualFileSystem::jsonToNode(const nlohmann::json& j, const std::string& name) {
-    NodeType type = (j.value("type", "file") == "directory") ? NodeType::DIRECTORY : NodeType::FILE;
-    std::string content = j.value("content", "");
+nlohmann::json VirtualFileSystem::nodeToJson(const FileSystemNode* node) const {
+    nlohmann::json j;
+
+    j["name"] = node->getName();
+    j["type"] = node->isDirectory() ? "directory" : node->isShortcut() ? "shortcut" : "file";
 
-    auto node = std::make_shared<FileSystemNode>(name, type, content);
+    const NodeMetadata& metadata = node->getMetadata();
+    j["mode"] = metadata.mode;
+    j["owner"] = NameTable::getInstance().getName(metadata.owner);
+    j["mtime"] = metadata.modifiedTime;
+    j["ctime"] = metadata.changedTime;
 
-    if (j.contains("children")) {
-        for (const auto& child : j["children"]) {
-            std::string childName = child.value("name", "");
-            auto childNode = jsonToNode(child, childName);
-            node->addChild(childNode);
+    if (node->isDirectory()) {
+        // Listing order keeps the output stable from one save to the next
+        j["children"] = nlohmann::json::array();
+        for (const FileSystemNode* child : node->getSortedChildren()) {
+            j["children"].push_back(nodeToJson(child));
         }
+    } else {
+        j["content"] = node->getContent();
     }
 
-    return node;
+    return j;
 }
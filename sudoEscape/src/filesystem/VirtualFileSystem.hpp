@@ -2,9 +2,63 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <functional>
 #include <stack>
+#include <string_view>
+#include <unordered_map>
 #include <nlohmann/json.hpp>
 #include "FileSystemNode.hpp"
+#include "NodeArena.hpp"
+#include "FlatNodeStore.hpp"
+#include "LevelSnapshot.hpp"
+#include "NodeNameIndex.hpp"
+#include "NodeContentIndex.hpp"
+#include "VfsJournal.hpp"
+#include "ParallelTreeWalker.hpp"
+#include "GlobPattern.hpp"
+
+struct GrepMatch {
+    std::string path;
+    size_t lineNumber;
+    std::string line;
+};
+
+// Totals for everything below a directory, the directory itself included
+struct TreeUsage {
+    size_t files = 0;
+    size_t directories = 0;
+    uint64_t bytes = 0;
+    // What those bytes take in memory, with compressed content counted at its
+    // compressed size
+    uint64_t storedBytes = 0;
+};
+
+// A change made to the tree, reported to subscribers once it is done. Paths
+// are absolute and only valid during the call; newPath is only set for MOVE.
+// RESET means the whole tree was replaced (a level, tree or save was
+// mounted) and everything derived from it is stale.
+struct VfsChange {
+    enum class Kind {
+        CREATE,
+        WRITE,
+        APPEND,
+        REMOVE,
+        MOVE,
+        RESET
+    };
+
+    Kind kind;
+    std::string_view path;
+    std::string_view newPath;
+};
+
+// Encodings of a whole-tree snapshot. All three carry the same document;
+// CBOR and MessagePack are the compact binary forms.
+enum class TreeFormat {
+    JSON,
+    CBOR,
+    MESSAGEPACK
+};
 
 class VirtualFileSystem {
 public:
@@ -14,41 +68,191 @@ public:
     // Initialization
     bool loadFromJson(const std::string& jsonFile);
     bool saveToJson(const std::string& jsonFile);
+    // Whole-tree snapshots of the session with node types and contents, as
+    // opposed to level files. Loading one mounts it in place of the level.
+    bool saveTree(const std::string& file, TreeFormat format);
+    bool loadTree(const std::string& file, TreeFormat format);
+    std::vector<uint8_t> encodeTree(TreeFormat format);
+    bool decodeTree(const std::vector<uint8_t>& data, TreeFormat format);
     void initializeFromLevel(const nlohmann::json& levelData);
 
+    // Persistence of the player's changes. Every mutation is journaled to
+    // savePrefix + ".journal"; with resume, a saved journal is first replayed
+    // over the loaded level, otherwise any previous save is discarded.
+    bool openJournal(const std::string& savePrefix, bool resume);
+    // Writes only what changed since the last save. Once the journal
+    // outgrows COMPACTION_THRESHOLD the whole tree is compacted into a new
+    // base image (savePrefix + ".<generation>.lvl") and the journal restarts.
+    bool saveChanges();
+
     // Navigation
     bool changeDirectory(const std::string& path);
     bool goBack();
-    std::string getCurrentPath() const;
+    const std::string& getCurrentPath() const;
     std::vector<FileSystemItem> listCurrentDirectory(bool showHidden = false) const;
+    // Entries whose names match the last component of pattern ("Logs/*.log"),
+    // in listing order. A pattern without wildcards naming a directory lists
+    // that directory instead.
+    std::vector<FileSystemItem> listMatching(const std::string& pattern, bool showHidden = false) const;
 
     // File operations
     std::string readFile(const std::string& filename) const;
+    // Reads a file in place instead of copying it out; the pointer is valid
+    // until the next change to the file system. nullptr if not a file.
+    const FileContent* getFileContent(const std::string& filename) const;
     bool writeFile(const std::string& filename, const std::string& content);
+    bool appendFile(const std::string& filename, const std::string& content);
     bool createFile(const std::string& filename, const std::string& content);
     bool deleteFile(const std::string& filename);
+    // Deletes every entry matching the last component of pattern; returns
+    // how many were deleted
+    size_t deleteMatching(const std::string& pattern);
+    // Moves or renames a file or directory. A destination naming an existing
+    // directory moves the source into it under its current name.
+    bool moveFile(const std::string& source, const std::string& destination);
 
     // Search operations
+    // Paths of all nodes whose name contains pattern, or matches it if it is
+    // a glob; a glob with several components ("**/Logs/*.log") is matched
+    // against whole paths
     std::vector<std::string> findFiles(const std::string& pattern) const;
     bool fileExists(const std::string& filename) const;
+    // Every line containing pattern in any file below directory
+    std::vector<GrepMatch> grepFiles(const std::string& pattern, const std::string& directory = ".") const;
+    // Sizes up the tree below directory; false if it does not exist
+    bool getTreeUsage(const std::string& directory, TreeUsage& usage) const;
+
+    // Resolves an absolute or relative path ("/desktop/Logs", "../Logs/./a")
+    // to a node, or nullptr if any component is missing. Shortcuts act as
+    // symbolic links to the path in their content, taken relative to their
+    // own directory: they are followed on the way to the last component,
+    // and at the last one too unless followShortcut is false. A lookup gives
+    // up after following MAX_SHORTCUT_HOPS of them, which catches loops.
+    FileSystemNode* resolvePath(const std::string& path, bool followShortcut = true) const;
+    static constexpr unsigned MAX_SHORTCUT_HOPS = 40;
+
+    // Change notifications, so caches over the tree can drop exactly what a
+    // change affects. Listeners are called in subscription order and must
+    // not change the file system or the subscriptions themselves.
+    using ChangeListener = std::function<void(const VfsChange&)>;
+    using SubscriptionId = uint32_t;
+    SubscriptionId subscribe(ChangeListener listener);
+    void unsubscribe(SubscriptionId id);
+
+    // Simulated time in seconds since the Unix epoch. Starts at the level's
+    // clock and advances one second with every change, which stamps the
+    // nodes it touches.
+    uint32_t getClock() const { return clock; }
 
     // Utility
     void printTree() const;
+    // Throws away everything the session changed by dropping its writable
+    // layer over the level; costs what the session wrote, not the level
+    // size. An open journal starts over as well.
     void reset();
 
 private:
-    std::shared_ptr<FileSystemNode> root;
-    std::shared_ptr<FileSystemNode> currentDirectory;
-    std::stack<std::shared_ptr<FileSystemNode>> directoryStack;
+    // Shared, read-only tree of the loaded level; the arena only holds the
+    // nodes this session copied on write, which together with their
+    // whiteouts form the writable layer over it
+    std::shared_ptr<const LevelSnapshot> baseSnapshot;
+    // The level as loaded, which reset() returns to; baseSnapshot differs
+    // from it once a compacted save has been resumed
+    std::shared_ptr<const LevelSnapshot> levelSnapshot;
+    NodeArena arena;
+    FileSystemNode* root;
+    FileSystemNode* currentDirectory;
+    std::stack<FileSystemNode*> directoryStack;
+
+    // Flat copy of the tree used for whole-tree scans, rebuilt lazily after
+    // structural changes
+    mutable FlatNodeStore flatStore;
+    mutable bool flatStoreDirty;
+
+    // Name search for find, kept current by createFile/deleteFile
+    NodeNameIndex nameIndex;
+    // Content search for grepFiles, kept current by every write
+    NodeContentIndex contentIndex;
+    // Scans the live tree for queries the indexes cannot narrow down
+    ParallelTreeWalker treeWalker;
+
+    uint32_t clock;
+
+    VfsJournal journal;
+    std::string savePrefix;
+    bool journaling;
+    // Generation of the save a new game's journal replaces; its base image
+    // is only removed once the new journal has been saved
+    uint32_t replacedGeneration;
+    static constexpr uint64_t COMPACTION_THRESHOLD = 4 * 1024 * 1024;
+
+    // Dentry-style cache for multi-component lookups, keyed by the directory
+    // the lookup started from. Each entry remembers the version of every
+    // directory it passed through and is dropped once any of them changes.
+    using Dependencies = std::vector<std::pair<const FileSystemNode*, uint32_t>>;
+    struct DentryKey {
+        const FileSystemNode* start;
+        std::string path;
+        bool followShortcut;
+
+        bool operator==(const DentryKey& other) const {
+            return start == other.start && path == other.path && followShortcut == other.followShortcut;
+        }
+    };
+    struct DentryKeyHash {
+        size_t operator()(const DentryKey& key) const {
+            return std::hash<std::string>()(key.path) ^ (std::hash<const void*>()(key.start) << 1) ^
+                   static_cast<size_t>(key.followShortcut);
+        }
+    };
+    struct DentryEntry {
+        FileSystemNode* target;
+        Dependencies dependencies;
+    };
+    static constexpr size_t DENTRY_CACHE_LIMIT = 4096;
+    mutable std::unordered_map<DentryKey, DentryEntry, DentryKeyHash> dentryCache;
+
+    // Where each followed shortcut finally led, with the directories the
+    // walk there depended on, so a long chain is walked once and then
+    // resolves in a few version checks. The hops it took are charged again
+    // on every use, so the limit does not depend on what is cached.
+    // Failures are not kept since they may only be down to the hops the rest
+    // of the lookup had used.
+    struct ShortcutTarget {
+        FileSystemNode* target;
+        unsigned hops;
+        Dependencies dependencies;
+    };
+    mutable std::unordered_map<const FileSystemNode*, ShortcutTarget> shortcutCache;
+
+    std::vector<std::pair<SubscriptionId, ChangeListener>> listeners;
+    SubscriptionId nextSubscription;
 
-    void initializeDefaultStructure();
-    void createDirectoryStructure(std::shared_ptr<FileSystemNode> parent, const nlohmann::json& locationData);
-    void findFilesRecursive(std::shared_ptr<FileSystemNode> node, const std::string& pattern, 
-                           std::vector<std::string>& results, const std::string& currentPath) const;
-    std::string getNodePath(std::shared_ptr<FileSystemNode> node) const;
-    void printTreeRecursive(std::shared_ptr<FileSystemNode> node, const std::string& prefix) const;
+    void mount(std::shared_ptr<const LevelSnapshot> snapshot);
+    void mountLevel(std::shared_ptr<const LevelSnapshot> snapshot);
+    FileSystemNode* getStartDirectory() const;
+    void replayJournal(const std::vector<VfsJournal::Record>& records);
+    bool compactJournal();
+    std::string getBaseImagePath(uint32_t generation) const;
+    // The session's writable copy of node, or nullptr if its path no longer
+    // leads anywhere in the session's tree
+    FileSystemNode* makeWritable(FileSystemNode* node);
+    FileSystemNode* currentVersionOf(FileSystemNode* node) const;
+    static std::vector<NameId> getNamePath(const FileSystemNode* node);
+    FileSystemNode* walkPath(FileSystemNode* start, std::string_view path, Dependencies* dependencies,
+                             bool followShortcut, unsigned& hops) const;
+    FileSystemNode* followShortcut(FileSystemNode* directory, const FileSystemNode* shortcut,
+                                   Dependencies* dependencies, unsigned& hops) const;
+    static bool isCurrent(const Dependencies& dependencies);
+    FileSystemNode* resolveParent(const std::string& path, std::string& leafName) const;
+    bool containsCurrentDirectory(const FileSystemNode* node) const;
+    static bool isWithin(const FileSystemNode* node, const FileSystemNode* ancestor);
+    FileSystemNode* thawSubtree(FileSystemNode* parent, FileSystemNode* node);
+    void indexSubtree(const FileSystemNode* node);
+    const FlatNodeStore& getFlatStore() const;
+    void markStructureChanged() { flatStoreDirty = true; }
+    void notify(VfsChange::Kind kind, std::string_view path, std::string_view newPath = {}) const;
 
     // JSON conversion helpers
-    nlohmann::json nodeToJson(std::shared_ptr<FileSystemNode> node) const;
-    std::shared_ptr<FileSystemNode> jsonToNode(const nlohmann::json& j, const std::string& name);
+    nlohmann::json nodeToJson(const FileSystemNode* node) const;
 };
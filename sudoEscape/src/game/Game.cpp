@@ -1,7 +1,6 @@
 #include "Game.hpp"
 #include "MenuSystem.hpp"
 #include "../utils/Logger.hpp"
-#include "../test_json_debug.hpp"
 #include <iostream>
 #include <thread>
 #include <chrono>
@@ -17,9 +16,6 @@ Game::~Game() = default;
 void Game::startNewGame() {
     Logger::getInstance().log("Starting new game");
 
-    // Debug JSON loading at startup
-    debugLoadJson("../data/levels/level1.json");
-
     // Initialize fresh game state
     gameState->reset();
     gameState->setCurrentLevel(1);
@@ -39,6 +35,7 @@ void Game::resumeGame() {
     // Initialize the current level based on saved state
     if (gameState->getCurrentLevel() == 1) {
         currentLevel = std::make_unique<Level1>(*gameState, *scoreManager);
+        currentLevel->resumeFromSave();
     }
 
     // Resume the game loop
@@ -56,7 +53,11 @@ bool Game::loadGame() {
 
 bool Game::saveGame() {
     try {
-        return gameState->saveToFile("data/gamestate.json");
+        bool saved = gameState->saveToFile("data/gamestate.json");
+        if (currentLevel) {
+            saved = currentLevel->saveProgress() && saved;
+        }
+        return saved;
     } catch (const std::exception& e) {
         Logger::getInstance().log("Failed to save game: " + std::string(e.what()));
         return false;
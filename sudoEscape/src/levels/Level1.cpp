@@ -4,7 +4,7 @@
 #include <fstream>
 
 Level1::Level1(GameState& gs, ScoreManager& sm)
-    : Level(gs, sm) {
+    : Level(gs, sm), resumeSave(false) {
     commands = std::make_unique<Commands>(gameState, vfs);
 }
 
@@ -21,6 +21,14 @@ void Level1::initialize() {
         Logger::getInstance().log("[ERROR] Failed to load level1.json at: " + levelPath);
     }
 
+    // The player's file system changes live in a journal next to the save
+    if (!vfs.openJournal("data/vfs", resumeSave)) {
+        Logger::getInstance().log("[ERROR] File system changes will not be saved");
+    }
+    if (resumeSave) {
+        vfs.changeDirectory(gameState.getCurrentLocation());
+    }
+
     displayInitialMessage();
     startTime = std::chrono::steady_clock::now();
 }
@@ -47,9 +55,13 @@ bool Level1::executeCommand(const CommandResult& result) {
     else if (cmd == "cat") success = commands->cat(result.primaryArg);
     else if (cmd == "head") success = commands->head(result.primaryArg);
     else if (cmd == "tail") success = commands->tail(result.primaryArg);
+    else if (cmd == "grep" && args.size() >= 2 && args[0] == "-r") {
+        success = commands->grepRecursive(args[1], args.size() >= 3 ? args[2] : ".");
+    }
     else if (cmd == "grep" && args.size() >= 2) success = commands->grep(args[0], args[1]);
     else if (cmd == "strings") success = commands->strings(result.primaryArg);
     else if (cmd == "xxd") success = commands->xxd(result.primaryArg);
+    else if (cmd == "stat") success = commands->stat(result.primaryArg);
     else if (cmd == "base64") success = commands->base64(result.primaryArg);
     else if (cmd == "rot13") success = commands->rot13(result.primaryArg);
     else if (cmd == "decode") success = commands->decode(result.primaryArg);
@@ -60,10 +72,12 @@ bool Level1::executeCommand(const CommandResult& result) {
     }
     else if (cmd == "edit") success = commands->edit(result.primaryArg);
     else if (cmd == "rm" || cmd == "delete") success = commands->deleteFile(result.primaryArg);
+    else if (cmd == "mv") success = commands->mv(result.primaryArg, args.size() >= 2 ? args[1] : "");
     else if (cmd == "count") success = commands->count();
     else if (cmd == "history") success = commands->history();
     else if (cmd == "examine") success = commands->examine(result.primaryArg);
     else if (cmd == "find") success = commands->find(result.primaryArg);
+    else if (cmd == "du") success = commands->du(result.primaryArg.empty() ? "." : result.primaryArg);
     else if (cmd == "solve") success = commands->solve(result.primaryArg);
     else {
         std::cout << "Command not implemented." << std::endl;
@@ -84,7 +98,16 @@ bool Level1::isCompleted() const {
 void Level1::reset() {
     gameState.reset();
     scoreManager.reset();
-    initialize();
+    resumeSave = false;
+
+    // The level stays loaded; only the player's changes are dropped
+    vfs.reset();
+    displayInitialMessage();
+    startTime = std::chrono::steady_clock::now();
+}
+
+bool Level1::saveProgress() {
+    return vfs.saveChanges();
 }
 
 std::string Level1::getDescription() const {
@@ -21,10 +21,16 @@ public:
     void showHint() override;
     void showProgress() override;
 
+    // Restore the saved file system changes on the next initialize()
+    void resumeFromSave() { resumeSave = true; }
+    // Persists the file system changes made since the last save
+    bool saveProgress();
+
 private:
     VirtualFileSystem vfs;
     std::unique_ptr<Commands> commands;
     std::chrono::steady_clock::time_point startTime;
+    bool resumeSave;
 
     void displayInitialMessage();
 };
@@ -59,17 +59,21 @@ std::string CommandParser::getHelpText() const {
     help << "  cd <directory>    - Change to directory\n";
     help << "  ls                - List contents\n";
     help << "  ls -la            - List all contents (including hidden)\n";
+    help << "  ls -l[t|S][r]     - Long listing, newest or largest first, or reversed\n";
+    help << "  ls <pattern>      - List matching entries (*.log, auth.?og, [a-c]*)\n";
     help << "  pwd               - Show current directory\n";
     help << "  back              - Go back to previous directory\n";
-    help << "  open <item>       - Open file or shortcut\n";
+    help << "  open <item>       - Open file, folder or shortcut\n";
 
     help << "\nFile Analysis Commands:\n";
     help << "  cat <file>        - Display file contents\n";
     help << "  head <file>       - Show first lines of file\n";
     help << "  tail <file>       - Show last lines of file\n";
     help << "  grep <pattern> <file> - Search for pattern in file\n";
+    help << "  grep -r <pattern> [dir] - Search all files below directory\n";
     help << "  strings <file>    - Extract text from binary file\n";
     help << "  xxd <file>        - Hexdump of file\n";
+    help << "  stat <file>       - Show size, owner, permissions and times\n";
 
     help << "\nDecoding Commands:\n";
     help << "  base64 <string>   - Decode Base64 string\n";
@@ -80,8 +84,9 @@ std::string CommandParser::getHelpText() const {
     help << "  touch <file>      - Create empty file\n";
     help << "  create <file> <content> - Create file with content\n";
     help << "  edit <file>       - Edit file contents\n";
-    help << "  rm <file>         - Remove file\n";
+    help << "  rm <file>         - Remove file (wildcards allowed)\n";
     help << "  delete <file>     - Delete file\n";
+    help << "  mv <src> <dest>   - Move or rename file\n";
 
     help << "\nUtility Commands:\n";
     help << "  help              - Show this help\n";
@@ -91,7 +96,8 @@ std::string CommandParser::getHelpText() const {
 
     help << "\nSpecial Commands:\n";
     help << "  examine <item>    - Examine item closely\n";
-    help << "  find <name>       - Find files by name\n";
+    help << "  find <name>       - Find files by name or pattern (**/Logs/*.log)\n";
+    help << "  du [dir]          - Show disk usage of a directory\n";
     help << "  solve <code>      - Submit solution code\n";
     help << "  pause             - Access pause menu\n";
 
@@ -120,6 +126,7 @@ void CommandParser::initializeCommands() {
     commandTypes["grep"] = CommandType::ANALYSIS;
     commandTypes["strings"] = CommandType::ANALYSIS;
     commandTypes["xxd"] = CommandType::ANALYSIS;
+    commandTypes["stat"] = CommandType::ANALYSIS;
 
     // Decoding commands
     commandTypes["base64"] = CommandType::DECODING;
@@ -132,6 +139,7 @@ void CommandParser::initializeCommands() {
     commandTypes["edit"] = CommandType::CRUD;
     commandTypes["rm"] = CommandType::CRUD;
     commandTypes["delete"] = CommandType::CRUD;
+    commandTypes["mv"] = CommandType::CRUD;
 
     // Utility commands
     commandTypes["help"] = CommandType::UTILITY;
@@ -142,6 +150,7 @@ void CommandParser::initializeCommands() {
     // Special commands
     commandTypes["examine"] = CommandType::SPECIAL;
     commandTypes["find"] = CommandType::SPECIAL;
+    commandTypes["du"] = CommandType::SPECIAL;
     commandTypes["solve"] = CommandType::SPECIAL;
 
     // Build reverse mapping
@@ -2,9 +2,10 @@
 #include "../utils/Logger.hpp"
 #include <iostream>
 #include <algorithm>
-#include <sstream>
-#include <regex>
+#include <cctype>
+#include <iomanip>
 #include <fstream>
+#include <sstream>
 
 Commands::Commands(GameState& gs, VirtualFileSystem& fs) 
     : gameState(gs), fileSystem(fs) {}
@@ -33,32 +34,68 @@ bool Commands::cd(const std::string& directory) {
 bool Commands::ls(const std::vector<std::string>& args) {
     addToHistory("ls");
 
+    enum class SortKey { NAME, TIME, SIZE };
+
     bool showAll = false;
     bool longFormat = false;
+    bool reverse = false;
+    SortKey sortKey = SortKey::NAME;
+    std::string pattern;
 
     for (const auto& arg : args) {
-        if (arg == "-la" || arg == "-al") {
-            showAll = true;
-            longFormat = true;
-        } else if (arg == "-l") {
-            longFormat = true;
-        } else if (arg == "-a") {
-            showAll = true;
+        if (arg.size() > 1 && arg.front() == '-') {
+            // Flags combine as in "-la" or "-ltr"; the last sort flag wins
+            for (char flag : arg.substr(1)) {
+                switch (flag) {
+                    case 'a': showAll = true; break;
+                    case 'l': longFormat = true; break;
+                    case 'r': reverse = true; break;
+                    case 't': sortKey = SortKey::TIME; break;
+                    case 'S': sortKey = SortKey::SIZE; break;
+                    default: break;
+                }
+            }
+        } else if (!arg.empty() && arg.front() != '-') {
+            pattern = arg;
         }
     }
 
-    auto items = fileSystem.listCurrentDirectory(showAll);
+    auto items = pattern.empty() ? fileSystem.listCurrentDirectory(showAll)
+                                 : fileSystem.listMatching(pattern, showAll);
+
+    // Listings come in name order, which stays the tie-breaker
+    if (sortKey == SortKey::TIME) {
+        std::stable_sort(items.begin(), items.end(), [](const FileSystemItem& a, const FileSystemItem& b) {
+            return a.metadata.modifiedTime > b.metadata.modifiedTime;
+        });
+    } else if (sortKey == SortKey::SIZE) {
+        std::stable_sort(items.begin(), items.end(),
+                         [](const FileSystemItem& a, const FileSystemItem& b) { return a.size > b.size; });
+    }
+    if (reverse) {
+        std::reverse(items.begin(), items.end());
+    }
 
     if (items.empty()) {
+        if (!pattern.empty()) {
+            std::cout << "ls: " << pattern << ": No such file or directory\n";
+            return false;
+        }
         std::cout << "Directory is empty.\n";
         return true;
     }
 
-    std::cout << "Contents of " << fileSystem.getCurrentPath() << ":\n";
+    std::cout << "Contents of " << (pattern.empty() ? fileSystem.getCurrentPath() : pattern) << ":\n";
     for (const auto& item : items) {
         if (longFormat) {
-            std::cout << (item.isDirectory ? "d" : "-") << "rw-r--r-- 1 user user ";
-            std::cout << item.size << " Jan 15 10:30 ";
+            // Padded in a local stream, whatever state earlier output left
+            // std::cout in
+            const std::string& owner = NameTable::getInstance().getName(item.metadata.owner);
+            std::ostringstream line;
+            line << formatMode(item.type, item.metadata.mode) << " " << std::setw(2) << item.metadata.links << " "
+                 << owner << " " << owner << " " << std::setw(8) << item.size << " "
+                 << formatTime(item.metadata.modifiedTime, false) << " ";
+            std::cout << line.str();
         }
         std::cout << item.name;
         if (item.isDirectory) std::cout << "/";
@@ -110,6 +147,12 @@ bool Commands::open(const std::string& item) {
         return true;
     }
 
+    const FileSystemNode* node = fileSystem.resolvePath(item, false);
+    if (node && node->isShortcut()) {
+        std::cout << "Broken shortcut: " << item << " -> " << node->getContent() << "\n";
+        return false;
+    }
+
     std::cout << "Cannot open: " << item << "\n";
     return false;
 }
@@ -123,9 +166,13 @@ bool Commands::cat(const std::string& filename) {
         return false;
     }
 
-    std::string content = fileSystem.readFile(filename);
-    if (!content.empty()) {
-        std::cout << content << "\n";
+    const FileContent* content = fileSystem.getFileContent(filename);
+    if (content && !content->empty()) {
+        content->forEachChunk([](std::string_view chunk) {
+            std::cout << chunk;
+            return true;
+        });
+        std::cout << "\n";
         return true;
     } else {
         std::cout << "File not found or empty: " << filename << "\n";
@@ -141,20 +188,21 @@ bool Commands::head(const std::string& filename, int lines) {
         return false;
     }
 
-    std::string content = fileSystem.readFile(filename);
-    if (content.empty()) {
+    const FileContent* content = fileSystem.getFileContent(filename);
+    if (!content || content->empty()) {
         std::cout << "File not found: " << filename << "\n";
         return false;
     }
 
-    std::istringstream iss(content);
-    std::string line;
     int count = 0;
-
-    while (std::getline(iss, line) && count < lines) {
+    content->forEachLine([&](std::string_view line) {
+        if (count >= lines) {
+            return false;
+        }
         std::cout << line << "\n";
         count++;
-    }
+        return true;
+    });
 
     return true;
 }
@@ -167,24 +215,18 @@ bool Commands::tail(const std::string& filename, int lines) {
         return false;
     }
 
-    std::string content = fileSystem.readFile(filename);
-    if (content.empty()) {
+    const FileContent* content = fileSystem.getFileContent(filename);
+    if (!content || content->empty()) {
         std::cout << "File not found: " << filename << "\n";
         return false;
     }
 
-    std::vector<std::string> allLines;
-    std::istringstream iss(content);
-    std::string line;
-
-    while (std::getline(iss, line)) {
-        allLines.push_back(line);
-    }
-
-    int start = std::max(0, static_cast<int>(allLines.size()) - lines);
-    for (int i = start; i < static_cast<int>(allLines.size()); ++i) {
-        std::cout << allLines[i] << "\n";
-    }
+    // Scan back from the end instead of splitting the whole file
+    size_t start = content->findLastLines(static_cast<size_t>(std::max(0, lines)));
+    content->substr(start).forEachLine([](std::string_view line) {
+        std::cout << line << "\n";
+        return true;
+    });
 
     return true;
 }
@@ -197,22 +239,21 @@ bool Commands::grep(const std::string& pattern, const std::string& filename) {
         return false;
     }
 
-    std::string content = fileSystem.readFile(filename);
-    if (content.empty()) {
+    const FileContent* content = fileSystem.getFileContent(filename);
+    if (!content || content->empty()) {
         std::cout << "File not found: " << filename << "\n";
         return false;
     }
 
-    std::istringstream iss(content);
-    std::string line;
     bool found = false;
 
-    while (std::getline(iss, line)) {
-        if (line.find(pattern) != std::string::npos) {
+    content->forEachLine([&](std::string_view line) {
+        if (line.find(pattern) != std::string_view::npos) {
             std::cout << line << "\n";
             found = true;
         }
-    }
+        return true;
+    });
 
     if (!found) {
         std::cout << "Pattern not found: " << pattern << "\n";
@@ -221,6 +262,66 @@ bool Commands::grep(const std::string& pattern, const std::string& filename) {
     return found;
 }
 
+bool Commands::grepRecursive(const std::string& pattern, const std::string& directory) {
+    addToHistory("grep -r " + pattern + " " + directory);
+
+    if (pattern.empty()) {
+        std::cout << "Usage: grep -r <pattern> [directory]\n";
+        return false;
+    }
+
+    if (!fileSystem.fileExists(directory)) {
+        std::cout << "Directory not found: " << directory << "\n";
+        return false;
+    }
+
+    auto matches = fileSystem.grepFiles(pattern, directory);
+    if (matches.empty()) {
+        std::cout << "Pattern not found: " << pattern << "\n";
+        return false;
+    }
+
+    for (const auto& match : matches) {
+        std::cout << match.path << ":" << match.lineNumber << ": " << match.line << "\n";
+    }
+
+    return true;
+}
+
+bool Commands::stat(const std::string& path) {
+    addToHistory("stat " + path);
+
+    if (path.empty()) {
+        std::cout << "Usage: stat <file>\n";
+        return false;
+    }
+
+    // Like lstat: a shortcut is described itself, along with its target
+    const FileSystemNode* node = fileSystem.resolvePath(path, false);
+    if (!node) {
+        std::cout << "stat: " << path << ": No such file or directory\n";
+        return false;
+    }
+
+    const NodeMetadata& metadata = node->getMetadata();
+    const char* type = node->isDirectory() ? "directory" : node->isShortcut() ? "shortcut" : "regular file";
+    std::cout << "  File: " << node->getPath();
+    if (node->isShortcut()) {
+        std::cout << " -> " << node->getContent();
+    }
+    std::cout << "\n";
+
+    std::ostringstream details;
+    details << "  Size: " << std::left << std::setw(10) << node->getSize() << " Links: " << std::setw(5)
+            << metadata.links << " Type: " << type << "\n";
+    details << "Access: (0" << std::oct << metadata.mode << std::dec << "/" << formatMode(node->getType(), metadata.mode)
+            << ")  Owner: " << NameTable::getInstance().getName(metadata.owner) << "\n";
+    details << "Modify: " << formatTime(metadata.modifiedTime, true) << "\n";
+    details << "Change: " << formatTime(metadata.changedTime, true) << "\n";
+    std::cout << details.str();
+    return true;
+}
+
 bool Commands::strings(const std::string& filename) {
     addToHistory("strings " + filename);
 
@@ -229,20 +330,33 @@ bool Commands::strings(const std::string& filename) {
         return false;
     }
 
-    std::string content = fileSystem.readFile(filename);
-    if (content.empty()) {
+    const FileContent* content = fileSystem.getFileContent(filename);
+    if (!content || content->empty()) {
         std::cout << "File not found: " << filename << "\n";
         return false;
     }
 
-    // Extract printable strings (simplified implementation)
-    std::regex printableRegex("[[:print:]]{4,}");
-    std::sregex_iterator iter(content.begin(), content.end(), printableRegex);
-    std::sregex_iterator end;
-
-    for (; iter != end; ++iter) {
-        std::cout << iter->str() << "\n";
-    }
+    // Extract runs of at least 4 printable characters; a run may continue
+    // across chunks
+    std::string run;
+    auto flush = [&run]() {
+        if (run.size() >= 4) {
+            std::cout << run << "\n";
+        }
+        run.clear();
+    };
+
+    content->forEachChunk([&](std::string_view chunk) {
+        for (char c : chunk) {
+            if (std::isprint(static_cast<unsigned char>(c))) {
+                run += c;
+            } else {
+                flush();
+            }
+        }
+        return true;
+    });
+    flush();
 
     return true;
 }
@@ -255,23 +369,35 @@ bool Commands::xxd(const std::string& filename) {
         return false;
     }
 
-    std::string content = fileSystem.readFile(filename);
-    if (content.empty()) {
+    const FileContent* content = fileSystem.getFileContent(filename);
+    if (!content || content->empty()) {
         std::cout << "File not found: " << filename << "\n";
         return false;
     }
 
-    // Simple hex dump implementation
-    for (size_t i = 0; i < content.length(); i += 16) {
-        std::cout << std::hex << std::setfill('0') << std::setw(8) << i << ": ";
-
-        for (size_t j = 0; j < 16 && i + j < content.length(); ++j) {
-            std::cout << std::hex << std::setfill('0') << std::setw(2) 
-                     << (unsigned char)content[i + j] << " ";
+    // Simple hex dump implementation; rows of 16 bytes may span chunks.
+    // Rows are formatted in their own stream so the hex and fill settings
+    // never leak into std::cout.
+    size_t offset = 0;
+    std::ostringstream row;
+    row << std::hex << std::setfill('0');
+    content->forEachChunk([&offset, &row](std::string_view chunk) {
+        for (char c : chunk) {
+            if (offset % 16 == 0) {
+                if (offset > 0) {
+                    std::cout << row.str() << "\n";
+                    row.str("");
+                }
+                row << std::setw(8) << offset << ": ";
+            }
+
+            row << std::setw(2) << static_cast<unsigned int>(static_cast<unsigned char>(c)) << " ";
+            ++offset;
         }
+        return true;
+    });
 
-        std::cout << "\n";
-    }
+    std::cout << row.str() << "\n";
 
     return true;
 }
@@ -396,6 +522,16 @@ bool Commands::deleteFile(const std::string& filename) {
         return false;
     }
 
+    if (GlobPattern::hasWildcards(filename)) {
+        size_t deleted = fileSystem.deleteMatching(filename);
+        if (deleted == 0) {
+            std::cout << "No files match: " << filename << "\n";
+            return false;
+        }
+        std::cout << "Deleted " << deleted << " files matching: " << filename << "\n";
+        return true;
+    }
+
     if (fileSystem.deleteFile(filename)) {
         std::cout << "Deleted file: " << filename << "\n";
         return true;
@@ -405,6 +541,23 @@ bool Commands::deleteFile(const std::string& filename) {
     }
 }
 
+bool Commands::mv(const std::string& source, const std::string& destination) {
+    addToHistory("mv " + source + " " + destination);
+
+    if (source.empty() || destination.empty()) {
+        std::cout << "Usage: mv <source> <destination>\n";
+        return false;
+    }
+
+    if (fileSystem.moveFile(source, destination)) {
+        std::cout << "Moved " << source << " to " << destination << "\n";
+        return true;
+    } else {
+        std::cout << "Failed to move: " << source << "\n";
+        return false;
+    }
+}
+
 // Utility commands
 bool Commands::help() {
     addToHistory("help");
@@ -414,7 +567,7 @@ bool Commands::help() {
     std::cout << "Use the following commands to navigate and analyze evidence:\n\n";
 
     std::cout << "Navigation: cd, ls, pwd, back, open\n";
-    std::cout << "Analysis: cat, head, tail, grep, strings, xxd\n";
+    std::cout << "Analysis: cat, head, tail, grep, strings, xxd, stat\n";
     std::cout << "Decoding: base64, rot13, decode\n";
     std::cout << "File Ops: touch, create, edit, rm, delete\n";
     std::cout << "Utility: help, clear, count, history\n";
@@ -521,6 +674,20 @@ bool Commands::find(const std::string& name) {
     return true;
 }
 
+bool Commands::du(const std::string& directory) {
+    addToHistory("du " + directory);
+
+    TreeUsage usage;
+    if (!fileSystem.getTreeUsage(directory, usage)) {
+        std::cout << "du: " << directory << ": No such file or directory\n";
+        return false;
+    }
+
+    std::cout << usage.bytes << " bytes (" << usage.storedBytes << " stored) in " << usage.files
+              << " files and " << usage.directories << " directories\n";
+    return true;
+}
+
 bool Commands::solve(const std::string& code) {
     addToHistory("solve " + code);
 
@@ -543,6 +710,43 @@ bool Commands::solve(const std::string& code) {
 }
 
 // Helper methods
+std::string Commands::formatMode(NodeType type, uint16_t mode) {
+    std::string text = (type == NodeType::DIRECTORY) ? "d" : (type == NodeType::SHORTCUT) ? "l" : "-";
+    const char* letters = "rwx";
+    for (int bit = 8; bit >= 0; --bit) {
+        text += (mode & (1u << bit)) ? letters[(8 - bit) % 3] : '-';
+    }
+    return text;
+}
+
+std::string Commands::formatTime(uint32_t time, bool full) {
+    // Civil date from days since 1970-01-01 (UTC), valid for any uint32_t time
+    uint32_t days = time / 86400;
+    uint32_t seconds = time % 86400;
+    uint32_t shifted = days + 719468;
+    uint32_t era = shifted / 146097;
+    uint32_t dayOfEra = shifted - era * 146097;
+    uint32_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    uint32_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    uint32_t monthIndex = (5 * dayOfYear + 2) / 153;
+    uint32_t day = dayOfYear - (153 * monthIndex + 2) / 5 + 1;
+    uint32_t month = monthIndex < 10 ? monthIndex + 3 : monthIndex - 9;
+    uint32_t year = yearOfEra + era * 400 + (month <= 2 ? 1 : 0);
+
+    std::ostringstream out;
+    out << std::setfill('0');
+    if (full) {
+        out << year << "-" << std::setw(2) << month << "-" << std::setw(2) << day << " " << std::setw(2)
+            << seconds / 3600 << ":" << std::setw(2) << seconds / 60 % 60 << ":" << std::setw(2) << seconds % 60;
+    } else {
+        static const char* MONTHS[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                        "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+        out << MONTHS[month - 1] << " " << std::setfill(' ') << std::setw(2) << day << " " << std::setfill('0')
+            << std::setw(2) << seconds / 3600 << ":" << std::setw(2) << seconds / 60 % 60;
+    }
+    return out.str();
+}
+
 void Commands::addToHistory(const std::string& command) {
     commandHistory.push_back(command);
     if (commandHistory.size() > 100) {
@@ -22,8 +22,10 @@ public:
     bool head(const std::string& filename, int lines = 10);
     bool tail(const std::string& filename, int lines = 10);
     bool grep(const std::string& pattern, const std::string& filename);
+    bool grepRecursive(const std::string& pattern, const std::string& directory = ".");
     bool strings(const std::string& filename);
     bool xxd(const std::string& filename);
+    bool stat(const std::string& path);
 
     // Decoding commands
     bool base64(const std::string& input);
@@ -36,6 +38,7 @@ public:
     bool edit(const std::string& filename);
     bool rm(const std::string& filename);
     bool deleteFile(const std::string& filename);
+    bool mv(const std::string& source, const std::string& destination);
 
     // Utility commands
     bool help();
@@ -46,6 +49,7 @@ public:
     // Special commands
     bool examine(const std::string& item);
     bool find(const std::string& name);
+    bool du(const std::string& directory);
     bool solve(const std::string& code);
 
 private:
@@ -57,5 +61,9 @@ private:
     std::string rot13Decode(const std::string& input);
     std::string caesarDecode(const std::string& input, int shift);
     bool isBase64(const std::string& input);
+    // "drwxr-xr-x" style permissions
+    static std::string formatMode(NodeType type, uint16_t mode);
+    // "Jan 15 10:30", or "2025-01-15 10:30:00" if full
+    static std::string formatTime(uint32_t time, bool full);
     void addToHistory(const std::string& command);
 };
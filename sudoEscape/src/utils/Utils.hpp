@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdio>
 #include <string>
 #include <algorithm>
 
@@ -9,4 +10,8 @@ public:
         std::transform(result.begin(), result.end(), result.begin(), ::tolower);
         return result;
     }
+
+    // Pushes everything written to file down to the disk, so it survives a
+    // crash or power failure once this returns true
+    static bool syncFile(std::FILE* file);
 };
@@ -0,0 +1,431 @@
+// Generates synthetic levels for stress tests and benchmarks. The same
+// options and seed always produce byte-identical level JSON, on any
+// platform. The compiled image is identical apart from its source stamp,
+// which is the JSON's modification time so the game can tell when the
+// image is stale.
+// Not part of the game project; build it from the sudoEscape directory with
+//
+//   g++ -std=c++17 -O2 -Idependencies/include -Isrc tools/LevelGenerator.cpp
+//       src/filesystem/*.cpp src/utils/*.cpp -o level_generator
+//
+// and run it with --help for the options. Next to the level JSON it writes
+// the compiled .lvl image the game maps instead of parsing the JSON.
+
+#include "filesystem/LevelSnapshot.hpp"
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+    enum class SizeDistribution {
+        FIXED,
+        UNIFORM,
+        // Every power of two in the range equally likely: many small files,
+        // a few large ones
+        LOG_UNIFORM
+    };
+
+    struct Options {
+        uint64_t seed = 1;
+        size_t fanout = 4;
+        size_t depth = 4;
+        size_t minFiles = 4;
+        size_t maxFiles = 12;
+        size_t minSize = 64;
+        size_t maxSize = 4096;
+        SizeDistribution distribution = SizeDistribution::LOG_UNIFORM;
+        double hiddenRatio = 0.1;
+        size_t clues = 3;
+        std::string output = "data/levels/generated.json";
+        bool compileImage = true;
+    };
+
+    // splitmix64: tiny, fast and fully specified, unlike the standard
+    // distributions whose output differs between library implementations
+    class Random {
+    public:
+        explicit Random(uint64_t seed) : state(seed) {}
+
+        uint64_t next() {
+            uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+            z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+            z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+            return z ^ (z >> 31);
+        }
+
+        // Uniform in [low, high]
+        size_t range(size_t low, size_t high) {
+            return low + static_cast<size_t>(next() % (high - low + 1));
+        }
+
+        // True with probability numerator / 2^32
+        bool chance(uint64_t numerator) {
+            return (next() >> 32) < numerator;
+        }
+
+        template <typename T, size_t N>
+        const T& pick(const T (&items)[N]) {
+            return items[next() % N];
+        }
+
+    private:
+        uint64_t state;
+    };
+
+    const char* const DIRECTORY_NAMES[] = { "Logs", "Backups", "Scripts", "Documents", "Archive", "Config",
+                                            "Reports", "Mail", "Temp", "Cache", "Users", "Projects" };
+    const char* const USERS[] = { "admin", "backup", "root", "deploy", "www-data", "jenkins", "postgres" };
+    const char* const WORDS[] = { "server", "access", "denied", "granted", "rotate", "backup", "upload",
+                                  "session", "token", "password", "firewall", "audit", "kernel", "cron" };
+    const char BASE64_ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    enum class FileKind { LOG, SCRIPT, NOTE, BACKUP };
+
+    std::string ipAddress(Random& random) {
+        return "198.51.100." + std::to_string(random.range(1, 254));
+    }
+
+    // Random draws are sequenced one per statement: the evaluation order of
+    // operands within one expression differs between compilers
+
+    std::string timestamp(Random& random) {
+        std::string day = std::to_string(random.range(10, 28));
+        std::string hour = std::to_string(random.range(10, 23));
+        std::string minute = std::to_string(random.range(10, 59));
+        return day + "/Jan/2025:" + hour + ":" + minute;
+    }
+
+    std::string line(Random& random, FileKind kind) {
+        switch (kind) {
+            case FileKind::LOG: {
+                uint64_t form = random.next() % 3;
+                std::string user = random.pick(USERS);
+                std::string ip = ipAddress(random);
+                if (form == 0) {
+                    std::string time = timestamp(random);
+                    std::string page = random.pick(WORDS);
+                    std::string status = random.next() % 4 ? "200" : "403";
+                    return ip + " - - [" + time + "] \"GET /" + page + ".php\" " + status + " -\n";
+                }
+                if (form == 1) {
+                    std::string port = std::to_string(random.range(1024, 65535));
+                    return "Failed SSH login for " + user + " from " + ip + " port " + port + "\n";
+                }
+                return "Successful FTP login for " + user + " from " + ip + "\n";
+            }
+            case FileKind::SCRIPT: {
+                std::string command = random.next() % 3 ? "rm -rf /var/tmp/" : "# cleanup ";
+                std::string target = random.pick(WORDS);
+                std::string number = std::to_string(random.range(0, 999));
+                return command + target + "_" + number + "\n";
+            }
+            case FileKind::NOTE: {
+                std::string first = random.pick(WORDS);
+                std::string second = random.pick(WORDS);
+                std::string time = timestamp(random);
+                return "Check the " + first + " " + second + " before " + time + ".\n";
+            }
+            case FileKind::BACKUP:
+            default: {
+                std::string block(76, ' ');
+                for (char& c : block) {
+                    c = BASE64_ALPHABET[random.next() % 64];
+                }
+                return block + "\n";
+            }
+        }
+    }
+
+    size_t contentSize(Random& random, const Options& options) {
+        switch (options.distribution) {
+            case SizeDistribution::FIXED:
+                return options.minSize;
+            case SizeDistribution::UNIFORM:
+                return random.range(options.minSize, options.maxSize);
+            case SizeDistribution::LOG_UNIFORM:
+            default: {
+                size_t low = 0;
+                while ((size_t(2) << low) <= options.minSize) {
+                    ++low;
+                }
+                size_t high = low;
+                while ((size_t(2) << high) <= options.maxSize) {
+                    ++high;
+                }
+                size_t bucket = random.range(low, high);
+                size_t from = std::max(options.minSize, size_t(1) << bucket);
+                size_t to = std::min(options.maxSize, (size_t(2) << bucket) - 1);
+                return random.range(std::min(from, to), to);
+            }
+        }
+    }
+
+    class Generator {
+    public:
+        Generator(const Options& options) : options(options), random(options.seed), fileCount(0),
+                                            directoryCount(0) {
+            hiddenThreshold = static_cast<uint64_t>(options.hiddenRatio * 4294967296.0);
+        }
+
+        nlohmann::json generate() {
+            nlohmann::json level;
+            std::string exitCode = "EXIT_CODE_" + std::to_string(options.seed) + "_" +
+                                   std::to_string(random.next() % 1000000);
+            level["level_info"]["name"] = "Generated Level " + std::to_string(options.seed);
+            level["level_info"]["description"] = "Synthetic level for stress testing";
+            level["level_info"]["starting_location"] = "desktop";
+            level["level_info"]["goal"] = "Find the exit code: " + exitCode;
+
+            nlohmann::json& desktop = level["locations"]["desktop"];
+            desktop["name"] = "Desktop";
+            desktop["items"] = nlohmann::json::array();
+            fill(desktop["items"], "/desktop", 0);
+
+            embedClues(exitCode);
+            return level;
+        }
+
+        size_t getFileCount() const { return fileCount; }
+        size_t getDirectoryCount() const { return directoryCount; }
+
+    private:
+        struct FileEntry {
+            std::string path;
+            nlohmann::json* item;
+        };
+
+        const Options& options;
+        Random random;
+        uint64_t hiddenThreshold;
+        size_t fileCount;
+        size_t directoryCount;
+        std::vector<FileEntry> files;
+
+        void fill(nlohmann::json& items, const std::string& path, size_t level) {
+            size_t subdirectories = level < options.depth ? options.fanout : 0;
+            size_t fileTotal = random.range(options.minFiles, options.maxFiles);
+            // Reserve first so the pointers kept in files stay valid
+            items.get_ref<nlohmann::json::array_t&>().reserve(subdirectories + fileTotal);
+
+            for (size_t i = 0; i < fileTotal; ++i) {
+                items.push_back(makeFile());
+                files.push_back(FileEntry{ path + "/" + items.back()["name"].get<std::string>(), &items.back() });
+            }
+
+            for (size_t i = 0; i < subdirectories; ++i) {
+                std::string name = std::string(random.pick(DIRECTORY_NAMES)) + "_" + std::to_string(directoryCount++);
+                items.push_back({ { "name", name }, { "type", "folder" }, { "items", nlohmann::json::array() } });
+                fill(items.back()["items"], path + "/" + name, level + 1);
+            }
+        }
+
+        nlohmann::json makeFile() {
+            std::string id = std::to_string(fileCount++);
+            std::string name;
+            FileKind kind;
+            switch (random.next() % 4) {
+                case 0:
+                    kind = FileKind::LOG;
+                    name = std::string(random.pick(WORDS)) + "_" + id + ".log";
+                    // Rotated logs
+                    if (random.next() % 3 == 0) {
+                        name += "." + std::to_string(random.range(1, 9));
+                    }
+                    break;
+                case 1:
+                    kind = FileKind::SCRIPT;
+                    name = "cleanup_" + id + ".sh";
+                    break;
+                case 2:
+                    kind = FileKind::NOTE;
+                    name = "notes_" + id + ".txt";
+                    break;
+                default:
+                    kind = FileKind::BACKUP;
+                    name = std::string(random.pick(WORDS)) + "_" + id + ".backup";
+                    break;
+            }
+            if (random.chance(hiddenThreshold)) {
+                name = "." + name;
+            }
+
+            size_t size = contentSize(random, options);
+            std::string content = kind == FileKind::SCRIPT ? "#!/bin/bash\n" : "";
+            while (content.size() < size) {
+                content += line(random, kind);
+            }
+            content.resize(size);
+
+            return { { "name", name }, { "type", "file" }, { "content", content } };
+        }
+
+        void embedClues(const std::string& exitCode) {
+            if (files.empty() || options.clues == 0) {
+                return;
+            }
+
+            // Split the exit code into one fragment per clue, alternating the
+            // encodings the decode commands understand
+            size_t count = std::min(options.clues, files.size());
+            size_t fragmentLength = (exitCode.size() + count - 1) / count;
+            for (size_t i = 0; i < count; ++i) {
+                std::string fragment = exitCode.substr(std::min(i * fragmentLength, exitCode.size()), fragmentLength);
+                std::string clue = "PART " + std::to_string(i + 1) + "/" + std::to_string(count) + ": " + fragment;
+                bool useBase64 = i % 2 == 0;
+                std::string encoded = useBase64 ? base64(clue) : rot13(clue);
+
+                FileEntry& target = files[random.next() % files.size()];
+                std::string content = (*target.item)["content"].get<std::string>();
+                (*target.item)["content"] = content + (content.empty() || content.back() == '\n' ? "" : "\n") +
+                                            encoded + "\n";
+                std::cout << "clue " << (i + 1) << " (" << (useBase64 ? "base64" : "rot13") << "): "
+                          << target.path << "\n";
+            }
+        }
+
+        static std::string base64(const std::string& text) {
+            std::string out;
+            size_t i = 0;
+            for (; i + 2 < text.size(); i += 3) {
+                uint32_t group = (uint8_t(text[i]) << 16) | (uint8_t(text[i + 1]) << 8) | uint8_t(text[i + 2]);
+                for (int shift = 18; shift >= 0; shift -= 6) {
+                    out += BASE64_ALPHABET[(group >> shift) & 63];
+                }
+            }
+            if (i < text.size()) {
+                uint32_t group = uint8_t(text[i]) << 16;
+                if (i + 1 < text.size()) {
+                    group |= uint8_t(text[i + 1]) << 8;
+                }
+                out += BASE64_ALPHABET[(group >> 18) & 63];
+                out += BASE64_ALPHABET[(group >> 12) & 63];
+                out += i + 1 < text.size() ? BASE64_ALPHABET[(group >> 6) & 63] : '=';
+                out += '=';
+            }
+            return out;
+        }
+
+        static std::string rot13(std::string text) {
+            for (char& c : text) {
+                if (c >= 'a' && c <= 'z') {
+                    c = static_cast<char>('a' + (c - 'a' + 13) % 26);
+                } else if (c >= 'A' && c <= 'Z') {
+                    c = static_cast<char>('A' + (c - 'A' + 13) % 26);
+                }
+            }
+            return text;
+        }
+    };
+
+    void printUsage() {
+        std::cout << "Usage: level_generator [options]\n"
+                  << "  --seed N            random seed (1)\n"
+                  << "  --fanout N          subdirectories per directory (4)\n"
+                  << "  --depth N           directory levels below the desktop (4)\n"
+                  << "  --files MIN-MAX     files per directory (4-12)\n"
+                  << "  --size MIN-MAX      file size in bytes (64-4096)\n"
+                  << "  --distribution D    fixed, uniform or log (log)\n"
+                  << "  --hidden RATIO      share of hidden dotfiles, 0 to 1 (0.1)\n"
+                  << "  --clues N           encoded exit code fragments to plant (3)\n"
+                  << "  --output PATH       level JSON to write (data/levels/generated.json)\n"
+                  << "  --no-image          skip compiling the .lvl image\n";
+    }
+
+    bool parseRange(const std::string& text, size_t& low, size_t& high) {
+        size_t dash = text.find('-');
+        char* end = nullptr;
+        low = std::strtoull(text.c_str(), &end, 10);
+        high = dash == std::string::npos ? low : std::strtoull(text.c_str() + dash + 1, &end, 10);
+        return *end == '\0' && low <= high;
+    }
+
+    bool parseOptions(int argc, char* argv[], Options& options) {
+        for (int i = 1; i < argc; ++i) {
+            std::string flag = argv[i];
+            if (flag == "--no-image") {
+                options.compileImage = false;
+                continue;
+            }
+            if (flag == "--help" || i + 1 >= argc) {
+                return false;
+            }
+
+            std::string value = argv[++i];
+            if (flag == "--seed") {
+                options.seed = std::strtoull(value.c_str(), nullptr, 10);
+            } else if (flag == "--fanout") {
+                options.fanout = std::strtoull(value.c_str(), nullptr, 10);
+            } else if (flag == "--depth") {
+                options.depth = std::strtoull(value.c_str(), nullptr, 10);
+            } else if (flag == "--files") {
+                if (!parseRange(value, options.minFiles, options.maxFiles)) {
+                    return false;
+                }
+            } else if (flag == "--size") {
+                if (!parseRange(value, options.minSize, options.maxSize)) {
+                    return false;
+                }
+            } else if (flag == "--distribution") {
+                if (value == "fixed") {
+                    options.distribution = SizeDistribution::FIXED;
+                } else if (value == "uniform") {
+                    options.distribution = SizeDistribution::UNIFORM;
+                } else if (value == "log") {
+                    options.distribution = SizeDistribution::LOG_UNIFORM;
+                } else {
+                    return false;
+                }
+            } else if (flag == "--hidden") {
+                options.hiddenRatio = std::strtod(value.c_str(), nullptr);
+                if (options.hiddenRatio < 0.0 || options.hiddenRatio > 1.0) {
+                    return false;
+                }
+            } else if (flag == "--clues") {
+                options.clues = std::strtoull(value.c_str(), nullptr, 10);
+            } else if (flag == "--output") {
+                options.output = value;
+            } else {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage();
+        return 1;
+    }
+
+    Generator generator(options);
+    nlohmann::json level = generator.generate();
+
+    {
+        std::ofstream out(options.output, std::ios::binary | std::ios::trunc);
+        if (!out.is_open() || !(out << level.dump(4) << "\n")) {
+            std::cerr << "Cannot write " << options.output << "\n";
+            return 1;
+        }
+    }
+    std::cout << "wrote " << options.output << ": " << generator.getDirectoryCount() << " directories, "
+              << generator.getFileCount() << " files\n";
+
+    // Loading through the cache compiles the image, stamped with the JSON's
+    // modification time so the game accepts it
+    if (options.compileImage) {
+        if (!LevelSnapshotCache::getInstance().load(options.output)) {
+            std::cerr << "Cannot compile " << options.output << "\n";
+            return 1;
+        }
+        std::cout << "wrote " << LevelSnapshotCache::getImagePath(options.output) << "\n";
+    }
+
+    return 0;
+}
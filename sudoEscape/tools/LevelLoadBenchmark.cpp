@@ -0,0 +1,192 @@
+// Compares loading a level through a parsed JSON document (LevelSnapshot::
+// fromJson) with the streaming loader (LevelSnapshot::fromJsonFile) on
+// generated levels, measuring time and heap use. Not part of the game
+// project; build it from the sudoEscape directory with
+//
+//   g++ -std=c++17 -O2 -Idependencies/include -Isrc tools/LevelLoadBenchmark.cpp
+//       src/filesystem/*.cpp src/utils/*.cpp -o level_load_benchmark
+//
+// and run it with the level sizes to test (default: 10000 100000 1000000).
+// Heap use is counted by replacing the global operator new, so "peak" is the
+// most heap either loader held at once and "tree" what the finished snapshot
+// keeps. The streaming loader reads the file through a mapping, which is not
+// heap and is listed separately as the file size.
+
+#include "filesystem/LevelSnapshot.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+    std::atomic<size_t> liveBytes{ 0 };
+    std::atomic<size_t> peakBytes{ 0 };
+    // Each block starts with its size so delete can account for it
+    constexpr size_t HEADER_SIZE = alignof(std::max_align_t);
+}
+
+void* operator new(size_t size) {
+    void* block = std::malloc(size + HEADER_SIZE);
+    if (!block) {
+        throw std::bad_alloc();
+    }
+    *static_cast<size_t*>(block) = size;
+
+    size_t live = liveBytes += size;
+    size_t peak = peakBytes.load();
+    while (live > peak && !peakBytes.compare_exchange_weak(peak, live)) {
+    }
+    return static_cast<char*>(block) + HEADER_SIZE;
+}
+
+void operator delete(void* pointer) noexcept {
+    if (pointer) {
+        char* block = static_cast<char*>(pointer) - HEADER_SIZE;
+        liveBytes -= *reinterpret_cast<size_t*>(block);
+        std::free(block);
+    }
+}
+
+void operator delete(void* pointer, size_t) noexcept {
+    operator delete(pointer);
+}
+
+namespace {
+    constexpr size_t FILES_PER_DIRECTORY = 12;
+    constexpr size_t SUBDIRECTORIES_PER_DIRECTORY = 4;
+
+    // Same layout as the serialization benchmark: nodeCount nodes below the
+    // desktop, breadth-first
+    nlohmann::json generateLevel(size_t nodeCount) {
+        nlohmann::json level;
+        level["level_info"]["starting_location"] = "desktop";
+        nlohmann::json& desktop = level["locations"]["desktop"];
+        desktop["items"] = nlohmann::json::array();
+
+        std::vector<nlohmann::json*> pending{ &desktop };
+        size_t created = 0;
+        for (size_t next = 0; next < pending.size() && created < nodeCount; ++next) {
+            // Reserve first so the pointers to child folders stay valid
+            nlohmann::json& items = (*pending[next])["items"];
+            items = nlohmann::json::array();
+            items.get_ref<nlohmann::json::array_t&>().reserve(FILES_PER_DIRECTORY + SUBDIRECTORIES_PER_DIRECTORY);
+
+            for (size_t i = 0; i < FILES_PER_DIRECTORY && created < nodeCount; ++i, ++created) {
+                items.push_back({
+                    { "name", "session_" + std::to_string(created) + ".log" },
+                    { "type", "file" },
+                    { "content", "Failed SSH login for admin from 198.51.100." + std::to_string(created % 256) +
+                                 " port " + std::to_string(1024 + created % 60000) + "\n" }
+                });
+            }
+            for (size_t i = 0; i < SUBDIRECTORIES_PER_DIRECTORY && created < nodeCount; ++i, ++created) {
+                items.push_back({ { "name", "dir_" + std::to_string(created) }, { "type", "folder" } });
+                pending.push_back(&items.back());
+            }
+        }
+
+        return level;
+    }
+
+    std::shared_ptr<const LevelSnapshot> loadDocument(const std::string& path) {
+        std::ifstream file(path);
+        nlohmann::json document;
+        file >> document;
+        return LevelSnapshot::fromJson(document);
+    }
+
+    // Order-sensitive digest of every node, to check both loaders agree
+    uint64_t digest(const LevelSnapshot& snapshot) {
+        const FlatNodeStore& store = snapshot.getFlatStore();
+        uint64_t hash = 14695981039346656037ULL;
+        auto mix = [&hash](std::string_view bytes) {
+            for (char c : bytes) {
+                hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ULL;
+            }
+            hash = (hash ^ 0xff) * 1099511628211ULL;
+        };
+
+        std::string scratch;
+        for (NodeId id = FlatNodeStore::ROOT_ID; id < store.size(); ++id) {
+            mix(store.getName(id));
+            mix(std::to_string(static_cast<int>(store.getType(id))));
+            mix(store.getNode(id)->getFileContent().flatten(scratch));
+        }
+        return hash;
+    }
+
+    struct Measurement {
+        double milliseconds;
+        size_t peakBytes;
+        size_t treeBytes;
+        uint64_t digest;
+    };
+
+    template <typename Loader>
+    Measurement measure(Loader load) {
+        size_t before = liveBytes.load();
+        peakBytes.store(before);
+
+        auto start = std::chrono::steady_clock::now();
+        std::shared_ptr<const LevelSnapshot> snapshot = load();
+        double milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        Measurement result{ milliseconds, peakBytes.load() - before, liveBytes.load() - before, 0 };
+        result.digest = snapshot ? digest(*snapshot) : 0;
+        return result;
+    }
+
+    std::string megabytes(size_t bytes) {
+        std::ostringstream out;
+        out << std::fixed << std::setprecision(1) << bytes / (1024.0 * 1024.0) << " MB";
+        return out.str();
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i) {
+        sizes.push_back(static_cast<size_t>(std::strtoull(argv[i], nullptr, 10)));
+    }
+    if (sizes.empty()) {
+        sizes = { 10000, 100000, 1000000 };
+    }
+
+    std::string path = (std::filesystem::temp_directory_path() / "level_load_benchmark.json").string();
+
+    std::cout << std::left << std::setw(10) << "nodes" << std::setw(10) << "loader" << std::right << std::setw(12)
+              << "file" << std::setw(12) << "ms" << std::setw(14) << "peak heap" << std::setw(14) << "tree"
+              << "  same tree\n";
+
+    for (size_t size : sizes) {
+        {
+            std::ofstream out(path, std::ios::trunc);
+            out << generateLevel(size).dump(4);
+        }
+        size_t fileBytes = static_cast<size_t>(std::filesystem::file_size(path));
+
+        // Intern every name once up front so neither loader is charged for it
+        LevelSnapshot::fromJsonFile(path);
+
+        Measurement document = measure([&path]() { return loadDocument(path); });
+        Measurement streaming = measure([&path]() { return LevelSnapshot::fromJsonFile(path); });
+
+        for (const auto& [name, measurement] : { std::make_pair("document", document), std::make_pair("stream", streaming) }) {
+            std::cout << std::left << std::setw(10) << size << std::setw(10) << name << std::right << std::setw(12)
+                      << megabytes(fileBytes) << std::setw(12) << std::fixed << std::setprecision(1)
+                      << measurement.milliseconds << std::setw(14) << megabytes(measurement.peakBytes)
+                      << std::setw(14) << megabytes(measurement.treeBytes) << "  "
+                      << (document.digest == streaming.digest ? "yes" : "NO") << "\n";
+        }
+    }
+
+    std::filesystem::remove(path);
+    return 0;
+}
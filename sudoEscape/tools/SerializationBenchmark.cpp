@@ -0,0 +1,107 @@
+// Compares the JSON, CBOR and MessagePack tree encodings of
+// VirtualFileSystem on generated trees. Not part of the game project; build
+// it from the sudoEscape directory with
+//
+//   g++ -std=c++17 -O2 -Idependencies/include -Isrc tools/SerializationBenchmark.cpp
+//       src/filesystem/*.cpp src/utils/*.cpp -o serialization_benchmark
+//
+// and run it with the tree sizes to test (default: 1000 10000 100000 1000000).
+
+#include "filesystem/VirtualFileSystem.hpp"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+    constexpr size_t FILES_PER_DIRECTORY = 12;
+    constexpr size_t SUBDIRECTORIES_PER_DIRECTORY = 4;
+
+    // Level document with nodeCount nodes below the desktop, laid out
+    // breadth-first so every directory fills up before the next level starts
+    nlohmann::json generateLevel(size_t nodeCount) {
+        nlohmann::json level;
+        level["level_info"]["starting_location"] = "desktop";
+        nlohmann::json& desktop = level["locations"]["desktop"];
+        desktop["items"] = nlohmann::json::array();
+
+        std::vector<nlohmann::json*> pending{ &desktop };
+        size_t created = 0;
+        for (size_t next = 0; next < pending.size() && created < nodeCount; ++next) {
+            // Reserve first so the pointers to child folders stay valid
+            nlohmann::json& items = (*pending[next])["items"];
+            items = nlohmann::json::array();
+            items.get_ref<nlohmann::json::array_t&>().reserve(FILES_PER_DIRECTORY + SUBDIRECTORIES_PER_DIRECTORY);
+
+            for (size_t i = 0; i < FILES_PER_DIRECTORY && created < nodeCount; ++i, ++created) {
+                items.push_back({
+                    { "name", "session_" + std::to_string(created) + ".log" },
+                    { "type", "file" },
+                    { "content", "Failed SSH login for admin from 198.51.100." + std::to_string(created % 256) +
+                                 " port " + std::to_string(1024 + created % 60000) + "\n" }
+                });
+            }
+            for (size_t i = 0; i < SUBDIRECTORIES_PER_DIRECTORY && created < nodeCount; ++i, ++created) {
+                items.push_back({ { "name", "dir_" + std::to_string(created) }, { "type", "folder" } });
+                pending.push_back(&items.back());
+            }
+        }
+
+        return level;
+    }
+
+    double millisecondsSince(std::chrono::steady_clock::time_point start) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    const char* formatName(TreeFormat format) {
+        switch (format) {
+            case TreeFormat::CBOR: return "CBOR";
+            case TreeFormat::MESSAGEPACK: return "MessagePack";
+            case TreeFormat::JSON:
+            default: return "JSON";
+        }
+    }
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<size_t> sizes;
+    for (int i = 1; i < argc; ++i) {
+        sizes.push_back(static_cast<size_t>(std::strtoull(argv[i], nullptr, 10)));
+    }
+    if (sizes.empty()) {
+        sizes = { 1000, 10000, 100000, 1000000 };
+    }
+
+    std::cout << std::left << std::setw(10) << "nodes" << std::setw(13) << "format" << std::right
+              << std::setw(14) << "bytes" << std::setw(14) << "encode ms" << std::setw(14) << "decode ms"
+              << "  round trip\n";
+
+    for (size_t size : sizes) {
+        VirtualFileSystem source;
+        source.initializeFromLevel(generateLevel(size));
+
+        for (TreeFormat format : { TreeFormat::JSON, TreeFormat::CBOR, TreeFormat::MESSAGEPACK }) {
+            auto start = std::chrono::steady_clock::now();
+            std::vector<uint8_t> encoded = source.encodeTree(format);
+            double encodeTime = millisecondsSince(start);
+
+            VirtualFileSystem target;
+            start = std::chrono::steady_clock::now();
+            bool decoded = target.decodeTree(encoded, format);
+            double decodeTime = millisecondsSince(start);
+
+            // Children are written in listing order, so an exact round trip
+            // reproduces the same bytes
+            bool roundTrip = decoded && target.encodeTree(format) == encoded;
+
+            std::cout << std::left << std::setw(10) << size << std::setw(13) << formatName(format) << std::right
+                      << std::setw(14) << encoded.size() << std::setw(14) << std::fixed << std::setprecision(1)
+                      << encodeTime << std::setw(14) << decodeTime << "  " << (roundTrip ? "ok" : "FAILED") << "\n";
+        }
+    }
+
+    return 0;
+}